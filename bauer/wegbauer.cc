@@ -1258,19 +1258,13 @@ sint32 wegbauer_t::intern_calc_route(const vector_tpl<koord3d> &start, const vec
 	koord3d mini, maxi;
 	get_mini_maxi( ziel, mini, maxi );
 
-	// memory in static list ...
-	if(route_t::nodes==NULL) {
-		route_t::MAX_STEP = welt->get_settings().get_max_route_steps(); // may need very much memory => configurable
-		route_t::nodes = new route_t::ANode[route_t::MAX_STEP+4+1];
-	}
-
-	static binary_heap_tpl <route_t::ANode *> queue;
+	// get exclusively the tile list
+	route_t::search_context_t *context = route_t::GET_NODES(welt);
+	route_t::ANode *nodes = context->nodes;
+	binary_heap_tpl <route_t::ANode *> &queue = context->queue;
 
 	// initialize marker field
-	marker_t& marker = marker_t::instance(welt->get_size().x, welt->get_size().y);
-
-	// clear the queue (should be empty anyhow)
-	queue.clear();
+	marker_t &marker = context->marker;
 
 	// some thing for the search
 	grund_t *to;
@@ -1288,7 +1282,7 @@ sint32 wegbauer_t::intern_calc_route(const vector_tpl<koord3d> &start, const vec
 			// DBG_MESSAGE("wegbauer_t::intern_calc_route()","cannot start on (%i,%i,%i)",start.x,start.y,start.z);
 			continue;
 		}
-		tmp = &(route_t::nodes[step]);
+		tmp = &(nodes[step]);
 		step ++;
 
 		tmp->parent = NULL;
@@ -1303,14 +1297,12 @@ sint32 wegbauer_t::intern_calc_route(const vector_tpl<koord3d> &start, const vec
 
 	if( queue.empty() ) {
 		// no valid ground to start.
+		route_t::RELEASE_NODES(context);
 		return -1;
 	}
 
 	INT_CHECK("wegbauer 347");
 
-	// get exclusively the tile list
-	route_t::GET_NODE();
-
 	// to speed up search, but may not find all shortest ways
 	uint32 min_dist = 99999999;
 
@@ -1476,7 +1468,7 @@ DBG_DEBUG("insert to close","(%i,%i,%i)  f=%i",gr->get_pos().x,gr->get_pos().y,g
 			}
 
 			// not in there or taken out => add new
-			route_t::ANode *k=&(route_t::nodes[step]);
+			route_t::ANode *k=&(nodes[step]);
 			step++;
 
 			k->parent = tmp;
@@ -1501,7 +1493,7 @@ DBG_DEBUG("wegbauer_t::intern_calc_route()","steps=%i  (max %i) in route, open %
 #endif
 	INT_CHECK("wegbauer 194");
 
-	route_t::RELEASE_NODE();
+	route_t::RELEASE_NODES(context);
 
 	// target reached?
 	if(  !ziel.is_contained(gr->get_pos())  ||  step>=route_t::MAX_STEP  ||  tmp->parent==NULL  ||  tmp->g > maximum  ) {
@@ -473,6 +473,10 @@ grund_t::~grund_t()
 {
 	destroy_win((ptrdiff_t)this);
 
+	// the route graphs keep pointers to grounds; this covers also grounds replaced
+	// by planquadrat_t::boden_ersetzen(), which moves the ways to the new ground
+	way_graph_t::invalidate(pos);
+
 	// remove text from table
 	set_text(NULL);
 
@@ -667,13 +671,13 @@ void grund_t::set_halt(halthandle_t halt)
 	// and record the halt
 	if(  add  ) {
 		this_halt = halt;
-		flags |= is_halt_flag|dirty;
+		flags |= is_halt_flag;
 	}
 	else {
 		this_halt = halthandle_t();
 		flags &= ~is_halt_flag;
-		flags |= dirty;
 	}
+	set_flag(dirty);
 }
 
 
@@ -693,6 +697,17 @@ void grund_t::calc_bild()
 	objlist.calc_bild();
 	// since bridges may alter images of ways, this order is needed!
 	calc_bild_internal( false );
+	// water and foundations may have changed their height
+	update_plan_data();
+}
+
+
+void grund_t::update_plan_data() const
+{
+	planquadrat_t *plan = welt->access( pos.get_2d() );
+	if(  plan  &&  plan->get_boden_count() > 0  &&  plan->get_kartenboden() == this  ) {
+		plan->update_kartenboden_data();
+	}
 }
 
 
@@ -1793,6 +1808,9 @@ sint64 grund_t::neuen_weg_bauen(weg_t *weg, ribi_t::ribi ribi, player_t *player)
 
 		// may result in a crossing, but the wegebauer will recalc all images anyway
 		weg->calc_image();
+
+		// the route graphs do not know about this way yet
+		way_graph_t::invalidate(pos);
 	}
 	return cost;
 }
@@ -15,6 +15,7 @@
 #include "../simconst.h"
 #include "../dataobj/koord3d.h"
 #include "../dataobj/objlist.h"
+#include "../display/simview.h"
 #include "wege/weg.h"
 
 
@@ -220,7 +221,13 @@ public:
 	* Set Flags for the newly drawn changed ground
 	* @author Hj. Malthaner
 	*/
-	inline void set_flag(flag_values flag) {flags |= flag;}
+	inline void set_flag(flag_values flag) {
+		if(  flag == dirty  &&  !(flags & dirty)  ) {
+			// the display looks only at the reported tiles
+			karte_ansicht_t::mark_tile_changed( pos.get_2d() );
+		}
+		flags |= flag;
+	}
 
 	inline void clear_flag(flag_values flag) {flags &= ~flag;}
 	inline bool get_flag(flag_values flag) const {return (flags & flag) != 0;}
@@ -366,7 +373,13 @@ public:
 	*/
 	inline const koord3d& get_pos() const { return pos; }
 
-	inline void set_pos(koord3d newpos) { pos = newpos;}
+	/**
+	 * If this is the first ground of its tile, copies height and water flag
+	 * into the planquadrat_t (see planquadrat_t::update_kartenboden_data()).
+	 */
+	void update_plan_data() const;
+
+	inline void set_pos(koord3d newpos) { pos = newpos; update_plan_data(); }
 
 	// slope are now maintained locally
 	hang_t::typ get_grund_hang() const { return (hang_t::typ)slope; }
@@ -417,7 +430,7 @@ public:
 		}
 	}
 
-	void set_hoehe(int h) { pos.z = h;}
+	void set_hoehe(int h) { pos.z = h; update_plan_data(); }
 
 	// Helper functions for underground modes
 	//
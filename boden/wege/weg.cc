@@ -173,6 +173,7 @@ void weg_t::init()
 weg_t::~weg_t()
 {
 	alle_wege.remove(this);
+	way_graph_t::invalidate(get_pos());
 	player_t *player=get_owner();
 	if(player) {
 		player_t::add_maintenance( player,  -besch->get_wartung(), besch->get_finance_waytype() );
@@ -283,6 +284,7 @@ void weg_t::count_sign()
 {
 	// Either only sign or signal please ...
 	flags &= ~(HAS_SIGN|HAS_SIGNAL|HAS_CROSSING);
+	way_graph_t::invalidate(get_pos());
 	const grund_t *gr=welt->lookup(get_pos());
 	if(gr) {
 		uint8 i = 1;
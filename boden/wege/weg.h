@@ -13,6 +13,7 @@
 #include "../../simobj.h"
 #include "../../besch/weg_besch.h"
 #include "../../dataobj/koord3d.h"
+#include "../../dataobj/way_graph.h"
 
 
 class karte_t;
@@ -228,7 +229,7 @@ public:
 	* zur Reparatur mu folgen).
 	* @param ribi Richtungsbits
 	*/
-	void ribi_add(ribi_t::ribi ribi) { this->ribi |= (uint8)ribi;}
+	void ribi_add(ribi_t::ribi ribi) { this->ribi |= (uint8)ribi; way_graph_t::invalidate(get_pos()); }
 
 	/**
 	* Entfernt Richtungsbits von einem Weg.
@@ -238,7 +239,7 @@ public:
 	* zur Reparatur mu folgen).
 	* @param ribi Richtungsbits
 	*/
-	void ribi_rem(ribi_t::ribi ribi) { this->ribi &= (uint8)~ribi;}
+	void ribi_rem(ribi_t::ribi ribi) { this->ribi &= (uint8)~ribi; way_graph_t::invalidate(get_pos()); }
 
 	/**
 	* Setzt Richtungsbits fr den Weg.
@@ -248,7 +249,7 @@ public:
 	* zur Reparatur mu folgen).
 	* @param ribi Richtungsbits
 	*/
-	void set_ribi(ribi_t::ribi ribi) { this->ribi = (uint8)ribi;}
+	void set_ribi(ribi_t::ribi ribi) { this->ribi = (uint8)ribi; way_graph_t::invalidate(get_pos()); }
 
 	/**
 	* Ermittelt die unmaskierten Richtungsbits fr den Weg.
@@ -265,7 +266,7 @@ public:
 	* damit Fahrzeuge nicht "von hinten" ber Ampeln fahren knnen.
 	* @param ribi Richtungsbits
 	*/
-	void set_ribi_maske(ribi_t::ribi ribi) { ribi_maske = (uint8)ribi; }
+	void set_ribi_maske(ribi_t::ribi ribi) { ribi_maske = (uint8)ribi; way_graph_t::invalidate(get_pos()); }
 	ribi_t::ribi get_ribi_maske() const { return (ribi_t::ribi)ribi_maske; }
 
 	/**
@@ -312,13 +313,13 @@ public:
 	inline bool is_snow() const {return flags&IS_SNOW; }
 
 	// this is needed during a change from crossing to tram track
-	void clear_crossing() { flags &= ~HAS_CROSSING; }
+	void clear_crossing() { flags &= ~HAS_CROSSING; way_graph_t::invalidate(get_pos()); }
 
 	/**
 	 * Clear the has-sign flag when roadsign or signal got deleted.
 	 * As there is only one of signal or roadsign on the way we can safely clear both flags.
 	 */
-	void clear_sign_flag() { flags &= ~(HAS_SIGN | HAS_SIGNAL); }
+	void clear_sign_flag() { flags &= ~(HAS_SIGN | HAS_SIGNAL); way_graph_t::invalidate(get_pos()); }
 
 	inline void set_bild( image_id b ) { bild = b; }
 	image_id get_image() const {return bild;}
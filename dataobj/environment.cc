@@ -43,6 +43,8 @@ std::string env_t::server_admin_pw;
 std::string env_t::server_motd_filename;
 vector_tpl<std::string> env_t::listen;
 bool env_t::server_save_game_on_quit = false;
+sint32 env_t::server_checkpoint_interval = 0;
+bool env_t::server_compress_frames = true;
 
 sint32 env_t::server_frames_ahead = 4;
 sint32 env_t::additional_client_frames_behind = 0;
@@ -105,6 +107,7 @@ sint32 env_t::intercity_road_length;
 plainstring env_t::river_type[10];
 uint8 env_t::river_types;
 sint32 env_t::autosave;
+bool env_t::autosave_background;
 uint32 env_t::fps;
 sint16 env_t::max_acceleration;
 uint8 env_t::num_threads;
@@ -190,6 +193,7 @@ void env_t::init()
 
 	/* prissi: autosave every x months (0=off) */
 	autosave = 0;
+	autosave_background = true;
 
 	// default: make 25 frames per second (if possible)
 	fps=25;
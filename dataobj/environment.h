@@ -78,6 +78,13 @@ public:
 	/// if true a kill event will save the  game under recovery#portnr#.sve
 	static bool server_save_game_on_quit;
 
+	/// seconds between checkpoints for crash recovery (0=off)
+	/// @see network_journal_t
+	static sint32 server_checkpoint_interval;
+
+	/// send commands to clients in compressed frames (if they understand them)
+	static bool server_compress_frames;
+
 	/// @} end of Network-related settings
 
 
@@ -383,6 +390,9 @@ public:
 	/// @author prissi
 	static sint32 autosave;
 
+	/// compress and write autosaves in a background thread
+	static bool autosave_background;
+
 
 	/**
 	 * @name Midi/sound options
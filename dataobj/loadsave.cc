@@ -4,8 +4,12 @@
 #include <ctype.h>
 #include <assert.h>
 #include <errno.h>
+#ifndef _WIN32
+#include <sys/mman.h>
+#endif
 
 #include "../simtypes.h"
+#include "../simconst.h"
 #include "../macros.h"
 #include "../simversion.h"
 #include "../simmem.h"
@@ -14,12 +18,18 @@
 #include "loadsave.h"
 
 #include "../utils/simstring.h"
+#include "../tpl/vector_tpl.h"
+#include "environment.h"
 
 #include <zlib.h>
 #include <bzlib.h>
 
 #define INVALID_RDWR_ID (-1)
 
+// start of files in the mode zipped_blocks
+#define ZBLOCK_MAGIC "SIMBLOCK"
+#define ZBLOCK_MAGIC_LEN (8)
+
 // buffer size for read/write - bzip2 gains up to 8M for non-threaded, 1M for threaded. binary, zipped ok with 256K or smaller.
 #define LS_BUF_SIZE (1024*1024)
 
@@ -80,10 +90,246 @@ struct file_descriptors_t {
 	gzFile gzfp;
 	BZFILE *bzfp;
 	int bse;
-	file_descriptors_t() : fp(NULL), gzfp(NULL), bzfp(NULL), bse(BZ_OK+1) {}
+	// when saving into memory: the uncompressed data in blocks of LS_BUF_SIZE
+	bool to_memory;
+	vector_tpl<char *> mem_blocks;
+	size_t mem_last_len;
+	// mode zipped_blocks: the blocks (de)compressed together
+	struct zblock_t {
+		char *raw;
+		uLongf raw_len;
+		Bytef *packed;
+		uLongf packed_len;
+		bool ok;
+	};
+	zblock_t zblocks[MAX_THREADS];
+	uint32 zblock_count;     ///< blocks in use
+	uint32 zblock_read;      ///< loading: block to read from
+	uLongf zblock_pos;       ///< loading: position in this block
+	bool zblock_eof;         ///< loading: no more blocks in the file
+	bool zblock_error;
+
+	// loading uncompressed files: the whole file in memory and the read position
+	const uint8 *map;
+	size_t map_len;
+	size_t map_pos;
+
+	file_descriptors_t() : fp(NULL), gzfp(NULL), bzfp(NULL), bse(BZ_OK+1), to_memory(false), mem_last_len(0), map(NULL), map_len(0), map_pos(0) {
+		MEMZERO(zblocks);
+		reset_zblocks();
+	}
+
+	~file_descriptors_t() {
+		unmap();
+		free_mem_blocks();
+		for(  int i=0;  i<MAX_THREADS;  i++  ) {
+			delete [] zblocks[i].raw;
+			delete [] zblocks[i].packed;
+		}
+	}
+
+	void free_mem_blocks() {
+		FOR(vector_tpl<char *>, const b, mem_blocks) {
+			delete [] b;
+		}
+		mem_blocks.clear();
+	}
+
+	bool map_file();
+
+	void unmap() {
+		if(  map  ) {
+#ifndef _WIN32
+			munmap( const_cast<uint8 *>(map), map_len );
+#else
+			delete [] map;
+#endif
+			map = NULL;
+		}
+		map_len = map_pos = 0;
+	}
+
+	void reset_zblocks() {
+		zblock_count = zblock_read = 0;
+		zblock_pos = 0;
+		zblock_eof = zblock_error = false;
+	}
+
+	/// number of blocks handled at once
+	static uint32 get_zblock_batch() { return clamp( (int)env_t::num_threads, 1, MAX_THREADS ); }
+
+	zblock_t &get_zblock(uint32 i) {
+		if(  zblocks[i].raw == NULL  ) {
+			zblocks[i].raw = new char[LS_BUF_SIZE];
+			zblocks[i].packed = new Bytef[compressBound(LS_BUF_SIZE)];
+		}
+		return zblocks[i];
+	}
+
+	void run_zblocks(bool compress);
+	void write_zblocks();
+	bool read_zblocks();
 };
 
 
+// maps the whole (uncompressed) file fp into memory and closes fp
+bool file_descriptors_t::map_file()
+{
+	fseek( fp, 0, SEEK_END );
+	const long len = ftell( fp );
+	fseek( fp, 0, SEEK_SET );
+	if(  len <= 0  ) {
+		return false;
+	}
+#ifndef _WIN32
+	void *m = mmap( NULL, len, PROT_READ, MAP_PRIVATE, fileno(fp), 0 );
+	if(  m == MAP_FAILED  ) {
+		return false;
+	}
+	madvise( m, len, MADV_SEQUENTIAL );
+	map = (const uint8 *)m;
+#else
+	// no mmap: read it at once
+	uint8 *m = new uint8[len];
+	if(  fread( m, 1, len, fp ) != (size_t)len  ) {
+		delete [] m;
+		return false;
+	}
+	map = m;
+#endif
+	map_len = len;
+	map_pos = 0;
+	fclose( fp );
+	fp = NULL;
+	return true;
+}
+
+
+static void zblock_work(file_descriptors_t::zblock_t &b, bool compress)
+{
+	if(  compress  ) {
+		b.packed_len = compressBound(LS_BUF_SIZE);
+		b.ok = compress2( b.packed, &b.packed_len, (const Bytef *)b.raw, b.raw_len, Z_DEFAULT_COMPRESSION ) == Z_OK;
+	}
+	else {
+		// raw_len is the expected length
+		uLongf len = LS_BUF_SIZE;
+		b.ok = uncompress( (Bytef *)b.raw, &len, b.packed, b.packed_len ) == Z_OK  &&  len == b.raw_len;
+	}
+}
+
+
+#ifdef MULTI_THREAD
+typedef struct {
+	file_descriptors_t::zblock_t *blocks;
+	uint32 count;
+	bool compress;
+} zblock_param_t;
+
+
+static void zblock_thread(void *ptr, int thread_num)
+{
+	zblock_param_t *p = reinterpret_cast<zblock_param_t *>(ptr);
+	for(  uint32 i = thread_num;  i < p->count;  i += env_t::num_threads  ) {
+		zblock_work( p->blocks[i], p->compress );
+	}
+}
+#endif
+
+
+// (de)compresses all blocks in use, one thread per block
+void file_descriptors_t::run_zblocks(bool compress)
+{
+#ifdef MULTI_THREAD
+	if(  zblock_count > 1  ) {
+		// when saving in the background and the game uses the pool, this is done serially
+		zblock_param_t param;
+		param.blocks = zblocks;
+		param.count = zblock_count;
+		param.compress = compress;
+		simthread_run_parallel( zblock_thread, &param );
+		return;
+	}
+#endif
+	for(  uint32 i = 0;  i < zblock_count;  i++  ) {
+		zblock_work( zblocks[i], compress );
+	}
+}
+
+
+static void wr_uint32(FILE *fp, uint32 v)
+{
+	const uint8 b[4] = { (uint8)v, (uint8)(v>>8), (uint8)(v>>16), (uint8)(v>>24) };
+	fwrite( b, 1, 4, fp );
+}
+
+
+static bool rd_uint32(FILE *fp, uint32 &v)
+{
+	uint8 b[4];
+	if(  fread( b, 1, 4, fp ) != 4  ) {
+		return false;
+	}
+	v = b[0] | (b[1]<<8) | (b[2]<<16) | ((uint32)b[3]<<24);
+	return true;
+}
+
+
+// compresses the filled blocks and writes them in their order
+void file_descriptors_t::write_zblocks()
+{
+	run_zblocks( true );
+	for(  uint32 i = 0;  i < zblock_count;  i++  ) {
+		zblock_t &b = zblocks[i];
+		if(  !b.ok  ) {
+			zblock_error = true;
+			continue;
+		}
+		// each block: compressed length, uncompressed length, compressed data
+		wr_uint32( fp, b.packed_len );
+		wr_uint32( fp, b.raw_len );
+		fwrite( b.packed, 1, b.packed_len, fp );
+	}
+	zblock_count = 0;
+}
+
+
+// reads and decompresses the next blocks; false if there are none
+bool file_descriptors_t::read_zblocks()
+{
+	zblock_count = zblock_read = 0;
+	zblock_pos = 0;
+	while(  !zblock_eof  &&  zblock_count < get_zblock_batch()  ) {
+		uint32 packed_len, raw_len;
+		if(  !rd_uint32( fp, packed_len )  ||  !rd_uint32( fp, raw_len )  ||  packed_len == 0  ) {
+			// a zero length ends the file
+			zblock_eof = true;
+			break;
+		}
+		zblock_t &b = get_zblock( zblock_count );
+		if(  packed_len > compressBound(LS_BUF_SIZE)  ||  raw_len > LS_BUF_SIZE  ||  fread( b.packed, 1, packed_len, fp ) != packed_len  ) {
+			dbg->error( "loadsave_t::read()", "savegame corrupt, broken block" );
+			zblock_eof = zblock_error = true;
+			break;
+		}
+		b.packed_len = packed_len;
+		b.raw_len = raw_len;
+		zblock_count++;
+	}
+	run_zblocks( false );
+	for(  uint32 i = 0;  i < zblock_count;  i++  ) {
+		if(  !zblocks[i].ok  ) {
+			dbg->error( "loadsave_t::read()", "savegame corrupt, cannot decompress block" );
+			// use only the good blocks before
+			zblock_count = i;
+			zblock_eof = zblock_error = true;
+			break;
+		}
+	}
+	return zblock_count > 0;
+}
+
+
 loadsave_t::mode_t loadsave_t::save_mode = bzip2;	// default to use for saving
 loadsave_t::mode_t loadsave_t::autosave_mode = zipped;	// default to use for autosaving
 
@@ -106,7 +352,7 @@ loadsave_t::~loadsave_t()
 void loadsave_t::set_buffered(bool enable)
 {
 	if(  enable  ) {
-		if(  !buffered  ) {
+		if(  !buffered  &&  !fd->to_memory  &&  !is_zipped_blocks()  &&  fd->map == NULL  ) {
 			buffered = true;
 			curr_buff = 0;
 			buf_pos[0] = buf_pos[1] = 0;
@@ -170,13 +416,34 @@ bool loadsave_t::rd_open(const char *filename)
 	}
 	// now check for BZ2 format
 	char buf[80];
+	bool plain = false;
 	if(  fread( buf, 1, 80, fd->fp )==80  ) {
 		if(  buf[0]=='B'  &&  buf[1]=='Z'  ) {
 			mode = bzip2;
 		}
+		else if(  memcmp( buf, ZBLOCK_MAGIC, ZBLOCK_MAGIC_LEN )==0  ) {
+			mode = zipped_blocks;
+		}
+		else {
+			plain = strstart( buf, SAVEGAME_PREFIX )  ||  strstart( buf, XML_SAVEGAME_PREFIX );
+		}
 		fseek(fd->fp,0,SEEK_SET);
 	}
 
+	if(  mode==zipped_blocks  ) {
+		fseek( fd->fp, ZBLOCK_MAGIC_LEN, SEEK_SET );
+		fd->reset_zblocks();
+		// same as for bzip2
+		MEMZERO(buf);
+		if(  read( buf, sizeof(SAVEGAME_PREFIX) )!=sizeof(SAVEGAME_PREFIX)  ) {
+			close();
+			return false;
+		}
+		for(  int i=sizeof(SAVEGAME_PREFIX);  (uint8)buf[i-1] >= 32  &&  i<79;  i++  ) {
+			buf[i] = lsgetc();
+		}
+	}
+
 	if(  mode==bzip2  ) {
 		fd->bse = BZ_OK+1;
 		fd->bzfp = NULL;
@@ -200,7 +467,18 @@ bool loadsave_t::rd_open(const char *filename)
 		}
 	}
 
-	if(  mode!=bzip2  ) {
+	if(  plain  ) {
+		// not compressed at all: read directly from memory
+		if(  fd->map_file()  ) {
+			mode = binary;
+			int i = 0;
+			while(  i < 79  &&  fd->map_pos < fd->map_len  &&  (buf[i++] = fd->map[fd->map_pos++]) != '\n'  ) {
+			}
+			buf[i] = 0;
+		}
+	}
+
+	if(  mode!=bzip2  &&  mode!=zipped_blocks  &&  fd->map==NULL  ) {
 		fclose(fd->fp);
 		// and now with zlib ...
 		fd->gzfp = gzopen(filename, "rb");
@@ -273,6 +551,53 @@ bool loadsave_t::wr_open(const char *filename, mode_t m, const char *pak_extensi
 	mode = m;
 	close();
 
+	if(  !open_for_writing( filename )  ) {
+		return false;
+	}
+	write_header( pak_extension, savegame_version );
+	this->filename = filename;
+
+	return true;
+}
+
+
+bool loadsave_t::wr_open_memory(mode_t m, const char *pak_extension, const char *savegame_version)
+{
+	mode = m;
+	close();
+
+	fd->to_memory = true;
+	fd->mem_last_len = LS_BUF_SIZE;
+	write_header( pak_extension, savegame_version );
+	this->filename = "";
+
+	return true;
+}
+
+
+const char *loadsave_t::close_memory_to_file(const char *filename)
+{
+	assert(  fd->to_memory  &&  saving  );
+	fd->to_memory = false;
+
+	const char *success = NULL;
+	if(  open_for_writing( filename )  ) {
+		this->filename = filename;
+		for(  uint32 i=0;  i<fd->mem_blocks.get_count();  i++  ) {
+			write( fd->mem_blocks[i], i+1<fd->mem_blocks.get_count() ? LS_BUF_SIZE : fd->mem_last_len );
+		}
+		success = close();
+	}
+	else {
+		success = strerror(errno);
+	}
+	fd->free_mem_blocks();
+	return success;
+}
+
+
+bool loadsave_t::open_for_writing(const char *filename)
+{
 	if(  is_zipped()  ) {
 		// using zlib
 		fd->gzfp = gzopen(filename, "wb");
@@ -281,6 +606,13 @@ bool loadsave_t::wr_open(const char *filename, mode_t m, const char *pak_extensi
 		// no compression
 		fd->fp = fopen(filename, "wb");
 	}
+	else if(  is_zipped_blocks()  ) {
+		fd->fp = fopen(filename, "wb");
+		fd->reset_zblocks();
+		if(  fd->fp  ) {
+			fwrite( ZBLOCK_MAGIC, 1, ZBLOCK_MAGIC_LEN, fd->fp );
+		}
+	}
 	else if(  is_bzip2()  ) {
 		// XML or bzip ...
 		fd->fp = fopen(filename, "wb");
@@ -301,9 +633,12 @@ bool loadsave_t::wr_open(const char *filename, mode_t m, const char *pak_extensi
 	}
 
 	// check whether we could open the file
-	if(  is_zipped()  ?  fd->gzfp == NULL  :  fd->fp == NULL  ) {
-		return false;
-	}
+	return  is_zipped()  ?  fd->gzfp != NULL  :  fd->fp != NULL;
+}
+
+
+void loadsave_t::write_header(const char *pak_extension, const char *savegame_version)
+{
 	saving = true;
 
 	// get the right extension
@@ -341,11 +676,6 @@ bool loadsave_t::wr_open(const char *filename, mode_t m, const char *pak_extensi
 		write( str, n );
 		ident = 1;
 	}
-
-	this->mode = mode;
-	this->filename = filename;
-
-	return true;
 }
 
 
@@ -353,12 +683,31 @@ const char *loadsave_t::close()
 {
 	const char *success = NULL;
 
+	if(  fd->to_memory  ) {
+		// never written to a file
+		fd->free_mem_blocks();
+		fd->to_memory = false;
+	}
+
 	if(  is_xml()  &&  saving  &&  (!is_bzip2()  ||  fd->bse==BZ_OK)
 	     &&  (is_zipped()  ?  fd->gzfp != NULL :  fd->fp != NULL) ) {
 		// only write when close and no error occurred
 		const char *end = "\n</Simutrans>\n";
 		write( end, strlen(end) );
 	}
+	if(  is_zipped_blocks()  &&  fd->fp  ) {
+		if(  saving  ) {
+			// the last blocks and the end mark
+			fd->write_zblocks();
+			wr_uint32( fd->fp, 0 );
+			wr_uint32( fd->fp, 0 );
+		}
+		if(  fd->zblock_error  ) {
+			success = "cannot compress savegame";
+		}
+		fd->reset_zblocks();
+	}
+	fd->unmap();
 	if(  is_zipped()  &&  fd->gzfp) {
 		int err_no;
 		const char *err_str = gzerror( fd->gzfp, &err_no );
@@ -404,7 +753,16 @@ const char *loadsave_t::close()
  */
 bool loadsave_t::is_eof()
 {
-	if(  is_bzip2()  ) {
+	if(  fd->map  ) {
+		return fd->map_pos >= fd->map_len;
+	}
+	else if(  is_zipped_blocks()  ) {
+		if(  fd->zblock_read < fd->zblock_count  ) {
+			return false;
+		}
+		return !fd->read_zblocks();
+	}
+	else if(  is_bzip2()  ) {
 		if(  buffered  ) {
 			bool r;
 #ifdef MULTI_THREAD
@@ -493,6 +851,40 @@ size_t loadsave_t::write(const void *buf, size_t len)
 		}
 	}
 	else {
+		if(  fd->to_memory  ) {
+			// append to the blocks
+			size_t done = 0;
+			while(  done < len  ) {
+				if(  fd->mem_last_len == LS_BUF_SIZE  ) {
+					fd->mem_blocks.append( new char[LS_BUF_SIZE] );
+					fd->mem_last_len = 0;
+				}
+				const size_t n = min( len - done, (size_t)(LS_BUF_SIZE - fd->mem_last_len) );
+				memcpy( fd->mem_blocks.back() + fd->mem_last_len, (const char *)buf + done, n );
+				fd->mem_last_len += n;
+				done += n;
+			}
+			return len;
+		}
+		if(  is_zipped_blocks()  ) {
+			// fill the blocks, compress them when all are full
+			size_t done = 0;
+			while(  done < len  ) {
+				if(  fd->zblock_count == 0  ||  fd->zblocks[fd->zblock_count-1].raw_len == LS_BUF_SIZE  ) {
+					if(  fd->zblock_count == file_descriptors_t::get_zblock_batch()  ) {
+						fd->write_zblocks();
+					}
+					fd->get_zblock( fd->zblock_count ).raw_len = 0;
+					fd->zblock_count++;
+				}
+				file_descriptors_t::zblock_t &b = fd->zblocks[fd->zblock_count-1];
+				const size_t n = min( len - done, (size_t)(LS_BUF_SIZE - b.raw_len) );
+				memcpy( b.raw + b.raw_len, (const char *)buf + done, n );
+				b.raw_len += n;
+				done += n;
+			}
+			return len;
+		}
 		if(  is_zipped()  ) {
 			return gzwrite(fd->gzfp, const_cast<void *>(buf), len);
 		}
@@ -536,6 +928,15 @@ void loadsave_t::flush_buffer(int buf_num)
 
 size_t loadsave_t::read(void *buf, size_t len)
 {
+	if(  fd->map  ) {
+		// uncompressed file: copy from the mapping, but never behind its end
+		if(  len > fd->map_len - fd->map_pos  ) {
+			len = fd->map_len - fd->map_pos;
+		}
+		memcpy( buf, fd->map + fd->map_pos, len );
+		fd->map_pos += len;
+		return len;
+	}
 	if(  buffered  ) {
 		if(  len>=LS_BUF_SIZE*2  ) {
 			dbg->fatal("loadsave_t::read()","Request for %d too long", len);
@@ -581,7 +982,25 @@ size_t loadsave_t::read(void *buf, size_t len)
 		}
 	}
 	else {
-		if(  is_bzip2()  ) {
+		if(  is_zipped_blocks()  ) {
+			size_t done = 0;
+			while(  done < len  ) {
+				if(  fd->zblock_read >= fd->zblock_count  &&  !fd->read_zblocks()  ) {
+					break;
+				}
+				file_descriptors_t::zblock_t &b = fd->zblocks[fd->zblock_read];
+				const size_t n = min( len - done, (size_t)(b.raw_len - fd->zblock_pos) );
+				memcpy( (char *)buf + done, b.raw + fd->zblock_pos, n );
+				fd->zblock_pos += n;
+				done += n;
+				if(  fd->zblock_pos == b.raw_len  ) {
+					fd->zblock_read++;
+					fd->zblock_pos = 0;
+				}
+			}
+			return done;
+		}
+		else if(  is_bzip2()  ) {
 			if(  fd->bse==BZ_OK  ) {
 				BZ2_bzRead( &fd->bse, fd->bzfp, buf, len);
 			}
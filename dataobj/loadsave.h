@@ -25,6 +25,8 @@ struct file_descriptors_t;
  * </p>
  * Can now read and write 3 formats: text, binary and zipped
  * Input format is automatically detected.
+ * zipped_blocks splits the data into independent zlib blocks, which are
+ * compressed and decompressed by env_t::num_threads threads at once.
  * Output format has a default, changeable with set_savemode, but can be
  * overwritten in wr_open.
  *
@@ -34,7 +36,7 @@ struct file_descriptors_t;
 
 class loadsave_t {
 public:
-	enum mode_t { text=1, xml=2, binary=0, zipped=4, xml_zipped=6, bzip2=8, xml_bzip2=10 };
+	enum mode_t { text=1, xml=2, binary=0, zipped=4, xml_zipped=6, bzip2=8, xml_bzip2=10, zipped_blocks=16, xml_zipped_blocks=18 };
 
 private:
 	int mode;
@@ -76,6 +78,12 @@ private:
 
 	void flush_buffer(int buf_num);
 
+	/// opens the file for the current mode, without writing anything
+	bool open_for_writing(const char *filename);
+
+	/// starts saving: writes the version line or the XML header
+	void write_header(const char *pak_extension, const char *savegame_version);
+
 public:
 	static mode_t save_mode;	// default to use for saving
 	static mode_t autosave_mode; // default to use for autosaves and network mode client temp saves
@@ -88,6 +96,18 @@ public:
 	bool wr_open(const char *filename, mode_t mode, const char *pak_extension, const char *svaegame_version );
 	const char *close();
 
+	/**
+	 * Saves into memory first: nothing is compressed or written, until close_memory_to_file()
+	 * is called. Then the whole data is written at once, which can be done by another thread.
+	 */
+	bool wr_open_memory(mode_t mode, const char *pak_extension, const char *savegame_version );
+
+	/**
+	 * Compresses and writes everything saved since wr_open_memory() into the file and closes it.
+	 * @return NULL on success, else an error message (like close())
+	 */
+	const char *close_memory_to_file(const char *filename);
+
 	static void set_savemode(mode_t mode) { save_mode = mode; }
 	static void set_autosavemode(mode_t mode) { autosave_mode = mode; }
 
@@ -103,6 +123,7 @@ public:
 	bool is_saving() const { return saving; }
 	bool is_zipped() const { return mode&zipped; }
 	bool is_bzip2() const { return mode&bzip2; }
+	bool is_zipped_blocks() const { return mode&zipped_blocks; }
 	bool is_xml() const { return mode&xml; }
 	uint32 get_version() const { return version; }
 	const char *get_pak_extension() const { return pak_extension; }
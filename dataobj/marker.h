@@ -11,7 +11,7 @@ class grund_t;
 
 /**
  * Class to mark tiles as visited during route search.
- * Singleton.
+ * Route searches have their own instances, everybody else uses the singleton.
  */
 class marker_t {
 	// Hajo: added bit mask, because it allows a more efficient
@@ -31,7 +31,10 @@ class marker_t {
 	/// hashtable to mark non-ground tiles (bridges, tunnels)
 	ptrhashtable_tpl <const grund_t *, bool> more;
 
-	marker_t() : bits(NULL) { init(0, 0); }
+	/// the instance
+	static marker_t the_instance;
+public:
+	marker_t() : bits(NULL), bits_groesse(0) { init(0, 0); }
 	~marker_t();
 
 	/**
@@ -41,9 +44,6 @@ class marker_t {
 	 */
 	void init(int welt_groesse_x,int welt_groesse_y);
 
-	/// the instance
-	static marker_t the_instance;
-public:
 	/**
 	 * Return handle to marker instance.
 	 * @param welt_groesse_x x-size of map
@@ -14,15 +14,30 @@
 #include "../boden/wege/weg.h"
 #include "../boden/grund.h"
 #include "../dataobj/marker.h"
+#include "../dataobj/way_graph.h"
 #include "../ifc/simtestdriver.h"
+#include "../utils/simrandom.h"
 #include "loadsave.h"
 #include "route.h"
 #include "environment.h"
 
+#ifdef MULTI_THREAD
+#include "../utils/simthread.h"
+#endif
+
 
 // if defined, print some profiling informations into the file
 //#define DEBUG_ROUTES
 
+// clusters of the coarse search for long water routes are ROUTE_CLUSTER_SIZE x ROUTE_CLUSTER_SIZE tiles
+#define ROUTE_CLUSTER_SIZE (16)
+// shorter routes are searched without corridor
+#define ROUTE_CORRIDOR_MIN_DIST (4*ROUTE_CLUSTER_SIZE)
+
+// flags of the clusters
+#define CLUSTER_CLOSED   (1)
+#define CLUSTER_CORRIDOR (2)
+
 // binary heap, the fastest
 #include "../tpl/binary_heap_tpl.h"
 
@@ -101,12 +116,157 @@ bool route_t::append_straight_route(karte_t *welt, koord3d dest )
 
 
 // node arrays
-route_t::ANode* route_t::nodes=NULL;
+route_t::search_context_t *route_t::contexts[MAX_THREADS];
 uint32 route_t::MAX_STEP=0;
-#ifdef DEBUG
-bool route_t::node_in_use=false;
+
+vector_tpl<route_t::prepared_search_t> route_t::prepared_searches;
+ptrhashtable_tpl<test_driver_t *, uint32> route_t::prepared_search_index;
+
+// no interrupts while searches are running in parallel
+static bool searches_in_parallel = false;
+
+#ifdef MULTI_THREAD
+static pthread_mutex_t search_context_mutex = PTHREAD_MUTEX_INITIALIZER;
 #endif
 
+
+route_t::search_context_t *route_t::GET_NODES(const karte_t *welt)
+{
+#ifdef MULTI_THREAD
+	pthread_mutex_lock( &search_context_mutex );
+#endif
+	if(  MAX_STEP == 0  ) {
+		MAX_STEP = welt->get_settings().get_max_route_steps(); // may need very much memory => configurable
+	}
+	search_context_t *context = NULL;
+	for(  int i=0;  i<MAX_THREADS;  i++  ) {
+		if(  contexts[i] == NULL  ) {
+			contexts[i] = new search_context_t();
+			contexts[i]->slot = i;
+		}
+		if(  !contexts[i]->in_use  ) {
+			context = contexts[i];
+			break;
+		}
+	}
+	if(  context == NULL  ) {
+		dbg->fatal("route_t::GET_NODES()","called while all lists in use");
+	}
+	context->in_use = true;
+#ifdef MULTI_THREAD
+	pthread_mutex_unlock( &search_context_mutex );
+#endif
+
+	if(  context->nodes == NULL  ) {
+		context->nodes = new ANode[MAX_STEP + 4 + 2];
+	}
+	context->marker.init( welt->get_size().x, welt->get_size().y );
+	context->queue.clear();
+	return context;
+}
+
+
+void route_t::RELEASE_NODES(search_context_t *context)
+{
+#ifdef MULTI_THREAD
+	pthread_mutex_lock( &search_context_mutex );
+#endif
+	if(  !context->in_use  ) {
+		dbg->fatal("route_t::RELEASE_NODES()","called while list free");
+	}
+	context->in_use = false;
+#ifdef MULTI_THREAD
+	pthread_mutex_unlock( &search_context_mutex );
+#endif
+}
+
+
+void route_t::add_prepared_search(test_driver_t *tdriver, koord3d start, koord3d ziel, sint32 max_speed)
+{
+	prepared_search_t search;
+	search.tdriver = tdriver;
+	search.start = start;
+	search.ziel = ziel;
+	search.max_speed = max_speed;
+	search.ok = false;
+	search.result = NULL;
+	prepared_search_index.put( tdriver, prepared_searches.get_count() );
+	prepared_searches.append( search );
+}
+
+
+void route_t::run_prepared_search(karte_t *welt, prepared_search_t &search)
+{
+	// same argument order as in calc_route()
+	search.result = new route_t();
+	search.ok = search.result->intern_calc_route( welt, search.ziel, search.start, search.tdriver, search.max_speed, 0xFFFFFFFFul );
+}
+
+
+#ifdef MULTI_THREAD
+static pthread_mutex_t prepared_search_mutex = PTHREAD_MUTEX_INITIALIZER;
+static uint32 next_prepared_search = 0;
+
+
+void route_t::prepared_search_thread(void *welt, int)
+{
+	// take the next search until all are done; the results do not depend on the order
+	while(true) {
+		pthread_mutex_lock( &prepared_search_mutex );
+		const uint32 i = next_prepared_search++;
+		pthread_mutex_unlock( &prepared_search_mutex );
+		if(  i >= prepared_searches.get_count()  ) {
+			break;
+		}
+		run_prepared_search( (karte_t *)welt, prepared_searches[i] );
+	}
+}
+#endif
+
+
+void route_t::prepare_searches(karte_t *welt)
+{
+	if(  prepared_searches.empty()  ) {
+		return;
+	}
+
+	set_random_mode( INTERACTIVE_RANDOM ); // do not allow simrand() here!
+
+	// the searches only read the graphs, so they must exist before
+	FOR(vector_tpl<prepared_search_t>, const& search, prepared_searches) {
+		way_graph_t::get_graph( search.tdriver->get_waytype() );
+	}
+	searches_in_parallel = true;
+
+#ifdef MULTI_THREAD
+	if(  env_t::num_threads > 1  &&  prepared_searches.get_count() > 1  ) {
+		next_prepared_search = 0;
+		simthread_run_parallel( prepared_search_thread, welt );
+	}
+	else
+#endif
+	{
+		FOR(vector_tpl<prepared_search_t>, &search, prepared_searches) {
+			run_prepared_search( welt, search );
+		}
+	}
+
+	searches_in_parallel = false;
+	way_graph_t::add_walked_edges();
+	clear_random_mode( INTERACTIVE_RANDOM );
+}
+
+
+void route_t::clear_prepared_searches()
+{
+	FOR(vector_tpl<prepared_search_t>, const& search, prepared_searches) {
+		delete search.result;
+	}
+	prepared_searches.clear();
+	prepared_search_index.clear();
+}
+
+
 /* find the route to an unknown location
  * @author prissi
  */
@@ -123,12 +283,6 @@ bool route_t::find_route(karte_t *welt, const koord3d start, test_driver_t *tdri
 	// some thing for the search
 	const waytype_t wegtyp = tdriver->get_waytype();
 
-	// memory in static list ...
-	if(  nodes == NULL  ) {
-		MAX_STEP = welt->get_settings().get_max_route_steps();
-		nodes = new ANode[MAX_STEP];
-	}
-
 	INT_CHECK("route 347");
 
 	// we clear it here probably twice: does not hurt ...
@@ -139,9 +293,12 @@ bool route_t::find_route(karte_t *welt, const koord3d start, test_driver_t *tdri
 		return false;
 	}
 
-	static binary_heap_tpl <ANode *> queue;
-
-	GET_NODE();
+	// memory in static list ...
+	search_context_t *context = GET_NODES(welt);
+	ANode *nodes = context->nodes;
+	binary_heap_tpl <ANode *> &queue = context->queue;
+	// nothing in lists
+	marker_t &marker = context->marker;
 
 	uint32 step = 0;
 	ANode* tmp = &nodes[step++];
@@ -151,10 +308,6 @@ bool route_t::find_route(karte_t *welt, const koord3d start, test_driver_t *tdri
 	tmp->f = 0;
 	tmp->g = 0;
 
-	// nothing in lists
-	marker_t& marker = marker_t::instance(welt->get_size().x, welt->get_size().y);
-
-	queue.clear();
 	queue.insert(tmp);
 
 	bool target_reached = false;
@@ -247,15 +400,14 @@ bool route_t::find_route(karte_t *welt, const koord3d start, test_driver_t *tdri
 		ok = !route.empty();
 	}
 
-	RELEASE_NODE();
+	RELEASE_NODES(context);
 	return ok;
 }
 
 
 
-ribi_t::ribi *get_next_dirs(const koord3d& gr_pos, const koord3d& ziel)
+static void get_next_dirs(const koord3d& gr_pos, const koord3d& ziel, ribi_t::ribi *next_ribi)
 {
-	static ribi_t::ribi next_ribi[4];
 	if( abs(gr_pos.x-ziel.x)>abs(gr_pos.y-ziel.y) ) {
 		next_ribi[0] = (ziel.x>gr_pos.x) ? ribi_t::ost : ribi_t::west;
 		next_ribi[1] = (ziel.y>gr_pos.y) ? ribi_t::sued : ribi_t::nord;
@@ -266,12 +418,137 @@ ribi_t::ribi *get_next_dirs(const koord3d& gr_pos, const koord3d& ziel)
 	}
 	next_ribi[2] = ribi_t::rueckwaerts( next_ribi[1] );
 	next_ribi[3] = ribi_t::rueckwaerts( next_ribi[0] );
-	return next_ribi;
 }
 
 
+bool route_t::search_context_t::is_in_corridor(koord k) const
+{
+	const koord c = k / ROUTE_CLUSTER_SIZE;
+	return  k.x >= 0  &&  k.y >= 0  &&  c.x < clusters_x  &&  c.y < clusters_y  &&  (clusters[c.y*clusters_x + c.x] & CLUSTER_CORRIDOR) != 0;
+}
+
+
+bool route_t::clusters_connected(karte_t *welt, test_driver_t *tdriver, koord c, ribi_t::ribi dir)
+{
+	const waytype_t wegtyp = tdriver->get_waytype();
+	// first tile on the border in direction dir and the step along the border
+	koord k = c * ROUTE_CLUSTER_SIZE;
+	koord along( 1, 0 );
+	if(  dir == ribi_t::ost  ) {
+		k.x += ROUTE_CLUSTER_SIZE - 1;
+		along = koord( 0, 1 );
+	}
+	else if(  dir == ribi_t::sued  ) {
+		k.y += ROUTE_CLUSTER_SIZE - 1;
+	}
+	else if(  dir == ribi_t::west  ) {
+		along = koord( 0, 1 );
+	}
+
+	for(  int i = 0;  i < ROUTE_CLUSTER_SIZE;  i++, k += along  ) {
+		const grund_t *gr = welt->lookup_kartenboden( k );
+		if(  gr == NULL  ) {
+			// outside the map
+			break;
+		}
+		// same conditions as in intern_calc_route() but without oneway signs,
+		// so clusters are connected whenever some of their tiles are
+		grund_t *to;
+		if(  (tdriver->get_ribi(gr) & dir)  &&  tdriver->check_next_tile(gr)  &&  gr->get_neighbour(to, wegtyp, dir)  &&  tdriver->check_next_tile(to)  ) {
+			return true;
+		}
+	}
+	return false;
+}
+
 
-bool route_t::intern_calc_route(karte_t *welt, const koord3d ziel, const koord3d start, test_driver_t *tdriver, const sint32 max_speed, const uint32 max_cost)
+bool route_t::calc_corridor(karte_t *welt, search_context_t *context, const koord3d start, const koord3d ziel, test_driver_t *tdriver)
+{
+	context->clusters_x = (welt->get_size().x + ROUTE_CLUSTER_SIZE - 1) / ROUTE_CLUSTER_SIZE;
+	context->clusters_y = (welt->get_size().y + ROUTE_CLUSTER_SIZE - 1) / ROUTE_CLUSTER_SIZE;
+	const uint32 count = context->clusters_x * context->clusters_y;
+	if(  context->cluster_count < count  ) {
+		delete [] context->clusters;
+		context->clusters = new uint8[count];
+		context->cluster_count = count;
+	}
+	MEMZERON( context->clusters, count );
+
+	// the nodes are not used by the tile search yet; here a node stands for the cluster of its ground
+	ANode *nodes = context->nodes;
+	binary_heap_tpl <ANode *> &queue = context->queue;
+
+	const koord cziel = ziel.get_2d() / ROUTE_CLUSTER_SIZE;
+	koord c = start.get_2d() / ROUTE_CLUSTER_SIZE;
+
+	uint32 step = 0;
+	ANode *tmp = &nodes[step];
+	step ++;
+	tmp->parent = NULL;
+	tmp->gr = welt->lookup_kartenboden( c * ROUTE_CLUSTER_SIZE );
+	tmp->g = 0;
+	tmp->f = koord_distance( c, cziel );
+	queue.insert( tmp );
+
+	bool ziel_erreicht = false;
+	while(  !queue.empty()  &&  step + 4 < MAX_STEP  ) {
+		tmp = queue.pop();
+		c = tmp->gr->get_pos().get_2d() / ROUTE_CLUSTER_SIZE;
+		uint8 &flags = context->clusters[c.y*context->clusters_x + c.x];
+		if(  flags & CLUSTER_CLOSED  ) {
+			continue;
+		}
+		flags |= CLUSTER_CLOSED;
+
+		if(  c == cziel  ) {
+			ziel_erreicht = true;
+			break;
+		}
+
+		for(  int r = 0;  r < 4;  r++  ) {
+			const koord next = c + koord( ribi_t::nsow[r] );
+			if(  next.x < 0  ||  next.y < 0  ||  next.x >= context->clusters_x  ||  next.y >= context->clusters_y  ) {
+				continue;
+			}
+			if(  (context->clusters[next.y*context->clusters_x + next.x] & CLUSTER_CLOSED)  ||  !clusters_connected( welt, tdriver, c, ribi_t::nsow[r] )  ) {
+				continue;
+			}
+			ANode *k = &nodes[step];
+			step ++;
+			k->parent = tmp;
+			k->gr = welt->lookup_kartenboden( next * ROUTE_CLUSTER_SIZE );
+			k->g = tmp->g + 1;
+			k->f = k->g + koord_distance( next, cziel );
+			queue.insert( k );
+		}
+	}
+	const bool exhausted = queue.empty();
+	queue.clear();
+
+	if(  !ziel_erreicht  ) {
+		if(  !exhausted  ) {
+			// too many clusters: search without corridor
+			memset( context->clusters, CLUSTER_CORRIDOR, count );
+			return true;
+		}
+		return false;
+	}
+
+	// the corridor: all clusters of the coarse route and their neighbours
+	for(  ;  tmp != NULL;  tmp = tmp->parent  ) {
+		c = tmp->gr->get_pos().get_2d() / ROUTE_CLUSTER_SIZE;
+		for(  sint16 y = max( c.y - 1, 0 );  y <= min( c.y + 1, context->clusters_y - 1 );  y++  ) {
+			for(  sint16 x = max( c.x - 1, 0 );  x <= min( c.x + 1, context->clusters_x - 1 );  x++  ) {
+				context->clusters[y*context->clusters_x + x] |= CLUSTER_CORRIDOR;
+			}
+		}
+	}
+	return true;
+}
+
+
+
+bool route_t::intern_calc_route(karte_t *welt, const koord3d ziel, const koord3d start, test_driver_t *tdriver, const sint32 max_speed, const uint32 max_cost, bool use_corridor)
 {
 	bool ok = false;
 
@@ -289,6 +566,11 @@ bool route_t::intern_calc_route(karte_t *welt, const koord3d ziel, const koord3d
 		return false;
 	}
 
+	// ways with a graph are searched junction by junction
+	if(  way_graph_t *graph = way_graph_t::get_graph( tdriver->get_waytype() )  ) {
+		return intern_calc_graph_route( welt, graph, ziel, start, tdriver, max_speed, max_cost );
+	}
+
 	// some thing for the search
 	const waytype_t wegtyp = tdriver->get_waytype();
 	const bool is_airplane = tdriver->get_waytype()==air_wt;
@@ -311,17 +593,24 @@ bool route_t::intern_calc_route(karte_t *welt, const koord3d ziel, const koord3d
 
 	bool ziel_erreicht=false;
 
-	// memory in static list ...
-	if(  nodes == NULL  ) {
-		MAX_STEP = welt->get_settings().get_max_route_steps(); // may need very much memory => configurable
-		nodes = new ANode[MAX_STEP + 4 + 2];
+	if(  !searches_in_parallel  ) {
+		INT_CHECK("route 347");
 	}
 
-	INT_CHECK("route 347");
-
-	static binary_heap_tpl <ANode *> queue;
+	// memory in static list ...
+	search_context_t *context = GET_NODES(welt);
+	ANode *nodes = context->nodes;
+	binary_heap_tpl <ANode *> &queue = context->queue;
+	// nothing in lists
+	marker_t &marker = context->marker;
 
-	GET_NODE();
+	// long routes on water are planned over clusters first, then searched tile by tile only near this coarse route
+	const bool corridor = use_jps  &&  use_corridor  &&  koord_distance( start, ziel ) > ROUTE_CORRIDOR_MIN_DIST;
+	if(  corridor  &&  !calc_corridor( welt, context, start, ziel, tdriver )  ) {
+		// not even the clusters are connected
+		RELEASE_NODES(context);
+		return false;
+	}
 
 	uint32 step = 0;
 	ANode* tmp = &nodes[step];
@@ -335,19 +624,15 @@ bool route_t::intern_calc_route(karte_t *welt, const koord3d ziel, const koord3d
 	tmp->count = 0;
 	tmp->ribi_from = ribi_t::keine;
 	tmp->jps_ribi  = ribi_t::alle;
+	tmp->prev_dir  = 0;
 
-	// nothing in lists
-	marker_t& marker = marker_t::instance(welt->get_size().x, welt->get_size().y);
-
-	// clear the queue (should be empty anyhow)
-	queue.clear();
 	queue.insert(tmp);
 	ANode* new_top = NULL;
 
 	uint32 beat=1;
 	do {
 		// Hajo: this is too expensive to be called each step
-		if((beat++ & 4095) == 0) {
+		if(  (beat++ & 4095) == 0  &&  !searches_in_parallel  ) {
 			INT_CHECK("route 161");
 		}
 
@@ -376,12 +661,21 @@ bool route_t::intern_calc_route(karte_t *welt, const koord3d ziel, const koord3d
 
 		uint32 topnode_f = !queue.empty() ? queue.front()->f : max_cost;
 
-		const ribi_t::ribi way_ribi =  tdriver->get_ribi(gr);
+		ribi_t::ribi way_ribi =  tdriver->get_ribi(gr);
+		if(  corridor  ) {
+			// the border of the corridor is an obstacle for the jump point search too
+			for(  int r=0;  r<4;  r++  ) {
+				if(  !context->is_in_corridor( gr->get_pos().get_2d() + koord(ribi_t::nsow[r]) )  ) {
+					way_ribi &= ~ribi_t::nsow[r];
+				}
+			}
+		}
 		// testing all four possible directions
 		// mask direction we came from
 		const ribi_t::ribi ribi =  way_ribi  &  ( ~ribi_t::reverse_single(tmp->ribi_from) )  &  tmp->jps_ribi;
 
-		const ribi_t::ribi *next_ribi = get_next_dirs(gr->get_pos(), ziel);
+		ribi_t::ribi next_ribi[4];
+		get_next_dirs(gr->get_pos(), ziel, next_ribi);
 		for(int r=0; r<4; r++) {
 
 			// a way in our direction?
@@ -472,6 +766,7 @@ bool route_t::intern_calc_route(karte_t *welt, const koord3d ziel, const koord3d
 				k->ribi_from = next_ribi[r];
 				k->count = tmp->count+1;
 				k->jps_ribi = ribi_t::alle;
+				k->prev_dir = tmp->dir;
 
 				if (use_jps  &&  to->ist_wasser()) {
 					// only check previous direction plus directions not available on this tile
@@ -504,7 +799,9 @@ bool route_t::intern_calc_route(karte_t *welt, const koord3d ziel, const koord3d
 	DBG_DEBUG("route_t::intern_calc_route()","steps=%i  (max %i) in route, open %i, cost %u (max %u)",step,MAX_STEP,queue.get_count(),tmp->g,max_cost);
 #endif
 
-	INT_CHECK("route 194");
+	if(  !searches_in_parallel  ) {
+		INT_CHECK("route 194");
+	}
 	// target reached?
 	if(!ziel_erreicht  || step >= MAX_STEP  ||  tmp->g >= max_cost  ||  tmp->parent==NULL) {
 		if(  step >= MAX_STEP  ) {
@@ -533,7 +830,225 @@ bool route_t::intern_calc_route(karte_t *welt, const koord3d ziel, const koord3d
 		ok = true;
 	}
 
-	RELEASE_NODE();
+	// the nodes may be used by another search after they were released
+	const bool below_max_cost = !ok  &&  tmp->g < max_cost;
+	RELEASE_NODES(context);
+
+	if(  !ok  &&  corridor  &&  step < MAX_STEP  &&  below_max_cost  ) {
+		// the route may leave the corridor, e.g. if the water in a cluster is not connected
+		return intern_calc_route( welt, ziel, start, tdriver, max_speed, max_cost, false );
+	}
+	return ok;
+}
+
+
+bool route_t::intern_calc_graph_route(karte_t *welt, way_graph_t *graph, const koord3d ziel, const koord3d start, test_driver_t *tdriver, const sint32 max_speed, const uint32 max_cost)
+{
+	const waytype_t wegtyp = graph->get_waytype();
+	const uint32 cost_upslope = tdriver->get_cost_upslope();
+
+	// memory in static list ...
+	search_context_t *context = GET_NODES(welt);
+	ANode *nodes = context->nodes;
+	binary_heap_tpl <ANode *> &queue = context->queue;
+	marker_t &marker = context->marker;
+
+	// the edge which lead to each node
+	vector_tpl<const way_graph_t::edge_t *> via(1024);
+	// edges from tiles which are not nodes of the graph
+	vector_tpl<way_graph_t::edge_t *> walked;
+
+	uint32 step = 0;
+	ANode* tmp = &nodes[step];
+	step ++;
+
+	tmp->parent = NULL;
+	tmp->gr = welt->lookup(start);
+	tmp->f = calc_distance(start,ziel);
+	tmp->g = 0;
+	tmp->dir = 0;
+	tmp->prev_dir = 0;
+	tmp->count = 0;
+	tmp->ribi_from = ribi_t::keine;
+	tmp->jps_ribi  = ribi_t::alle;
+	via.append( NULL );
+
+	queue.insert(tmp);
+
+	bool ziel_erreicht=false;
+	uint32 beat=1;
+	do {
+		// Hajo: this is too expensive to be called each step
+		if(  (beat++ & 1023) == 0  &&  !searches_in_parallel  ) {
+			INT_CHECK("route 161");
+		}
+
+		tmp = queue.pop();
+		const grund_t *gr = tmp->gr;
+		if(marker.test_and_mark(gr)) {
+			// we were already here on a faster route, thus ignore this branch
+			continue;
+		}
+
+		// we took the target pos out of the closed list
+		if(  ziel == gr->get_pos()  ) {
+			ziel_erreicht = true;
+			break;
+		}
+
+		// mask direction we came from
+		const ribi_t::ribi ribi = tdriver->get_ribi(gr)  &  ( ~ribi_t::reverse_single(tmp->ribi_from) );
+		const bool is_node = way_graph_t::is_node(gr, wegtyp);
+
+		for(  uint8 r=0;  r<4  &&  step < MAX_STEP;  r++  ) {
+			if(  (ribi & ribi_t::nsow[r])==0  ) {
+				continue;
+			}
+
+			const way_graph_t::edge_t *edge;
+			if(  is_node  ) {
+				// parallel searches must not change the graph
+				edge = searches_in_parallel ? graph->get_edge_parallel(gr, r, context->slot) : graph->get_edge(gr, r);
+			}
+			else {
+				// start, target or broken way: not in the graph
+				way_graph_t::edge_t *e = graph->walk(gr, r);
+				if(  e  ) {
+					walked.append( e );
+				}
+				edge = e;
+			}
+			if(  edge == NULL  ) {
+				continue;
+			}
+
+			// follow the edge with the same costs as intern_calc_route()
+			const grund_t *from = gr;
+			uint32 new_g = tmp->g;
+			uint8 dir = tmp->dir;
+			uint8 prev_dir = tmp->prev_dir;
+			ribi_t::ribi ribi_from = tmp->ribi_from;
+			uint32 count = tmp->count;
+
+			for(  uint32 i=0;  i<edge->tiles.get_count();  i++  ) {
+				const grund_t *to = edge->tiles[i];
+				const ribi_t::ribi next_ribi = i==0 ? ribi_t::nsow[r] : ribi_typ( from->get_pos(), to->get_pos() );
+
+				if(  !tdriver->check_next_tile(to)  ||  marker.is_marked(to)  ) {
+					break;
+				}
+				// Do not go on a tile, where a oneway sign forbids going.
+				const weg_t *w = to->get_weg(wegtyp);
+				if(  w  &&  (w->get_ribi_maske() & next_ribi)!=0  ) {
+					break;
+				}
+
+				new_g += w ? tdriver->get_cost(to, max_speed, from->get_pos().get_2d()) : 1;
+
+				uint8 current_dir;
+				if(  count > 0  ) {
+					current_dir = next_ribi | ribi_from;
+					if(dir!=current_dir) {
+						new_g += 3;
+						if(prev_dir!=dir  &&  count>1) {
+							// discourage 90 turns
+							new_g += 10;
+						}
+						else if(ribi_t::ist_exakt_orthogonal(dir,current_dir)) {
+							// discourage v turns heavily
+							new_g += 25;
+						}
+					}
+				}
+				else {
+					current_dir = next_ribi;
+				}
+				prev_dir = dir;
+				dir = current_dir;
+				ribi_from = next_ribi;
+				count ++;
+
+				const bool is_ziel = to->get_pos() == ziel;
+				if(  is_ziel  ||  i+1 == edge->tiles.get_count()  ) {
+					// reached a node (or the target): add it
+					uint32 dist = calc_distance( to->get_pos(), ziel );
+
+					// count how many 45 degree turns are necessary to get to target
+					sint8 turns = 0;
+					if (dist>1) {
+						ribi_t::ribi to_target = ribi_typ(to->get_pos(), ziel );
+
+						if (to_target  &&  (to_target!=current_dir)) {
+							if (ribi_t::ist_einfach(current_dir) != ribi_t::ist_einfach(to_target)) {
+								to_target = ribi_t::rotate45(to_target);
+								turns ++;
+							}
+							while(to_target!=current_dir) {
+								to_target = ribi_t::rotate90(to_target);
+								turns +=2;
+							}
+							if (turns>4) turns = 8-turns;
+						}
+					}
+
+					// take height difference into account when calculating distance
+					uint32 costup = 0;
+					if (cost_upslope) {
+						costup = cost_upslope * max(ziel.z - to->get_vmove(next_ribi), 0);
+					}
+
+					ANode* k = &nodes[step];
+					step ++;
+
+					k->parent = tmp;
+					k->gr = to;
+					k->g = new_g;
+					k->f = new_g + dist + turns * 3 + costup;
+					k->dir = current_dir;
+					k->prev_dir = prev_dir;
+					k->ribi_from = next_ribi;
+					k->count = count;
+					k->jps_ribi = ribi_t::alle;
+					via.append( edge );
+
+					queue.insert( k );
+					break;
+				}
+				from = to;
+			}
+		}
+
+	} while (  !queue.empty()  &&  step < MAX_STEP  &&  tmp->g < max_cost  );
+
+	if(  !searches_in_parallel  ) {
+		INT_CHECK("route 194");
+	}
+	// target reached?
+	bool ok = false;
+	if(!ziel_erreicht  || step >= MAX_STEP  ||  tmp->g >= max_cost  ||  tmp->parent==NULL) {
+		if(  step >= MAX_STEP  ) {
+			dbg->warning("route_t::intern_calc_graph_route()","Too many steps (%i>=max %i) in route (too long/complex)",step,MAX_STEP);
+		}
+	}
+	else {
+		// reached => construct route, the tiles between the nodes are from their edges
+		route.store_at( tmp->count, tmp->gr->get_pos() );
+		while(  tmp->parent != NULL  ) {
+			const way_graph_t::edge_t *edge = via[ tmp - nodes ];
+			const uint32 first = tmp->parent->count + 1;
+			for(  uint32 i = first;  i <= tmp->count;  i++  ) {
+				route[ i ] = edge->tiles[ i - first ]->get_pos();
+			}
+			tmp = tmp->parent;
+		}
+		route[ 0 ] = tmp->gr->get_pos();
+		ok = true;
+	}
+
+	FOR(vector_tpl<way_graph_t::edge_t *>, const e, walked) {
+		delete e;
+	}
+	RELEASE_NODES(context);
 
 	return ok;
 }
@@ -656,7 +1171,22 @@ route_t::route_result_t route_t::calc_route(karte_t *welt, const koord3d ziel, c
 
 	INT_CHECK("route 336");
 
-	bool ok = intern_calc_route(welt, start, ziel, tdriver, max_khm, 0xFFFFFFFFul );
+	// maybe this search was already done in advance
+	bool ok = false;
+	bool prepared = false;
+	if(  uint32 const* const i = prepared_search_index.access( tdriver )  ) {
+		prepared_search_t &search = prepared_searches[*i];
+		if(  search.result  &&  search.start == ziel  &&  search.ziel == start  &&  search.max_speed == max_khm  ) {
+			ok = search.ok;
+			swap( route, search.result->route );
+			delete search.result;
+			search.result = NULL;
+			prepared = true;
+		}
+	}
+	if(  !prepared  ) {
+		ok = intern_calc_route(welt, start, ziel, tdriver, max_khm, 0xFFFFFFFFul );
+	}
 #ifdef DEBUG_ROUTES
 	if(tdriver->get_waytype()==water_wt) {DBG_DEBUG("route_t::calc_route()","route from %d,%d to %d,%d with %i steps in %u ms found.",start.x, start.y, ziel.x, ziel.y, route.get_count()-1, dr_time()-ms );}
 #endif
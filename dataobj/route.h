@@ -9,14 +9,20 @@
 #define route_h
 
 #include "../simdebug.h"
+#include "../simconst.h"
 
 #include "../dataobj/koord3d.h"
+#include "../dataobj/marker.h"
+#include "../dataobj/ribi.h"
 
 #include "../tpl/vector_tpl.h"
+#include "../tpl/binary_heap_tpl.h"
+#include "../tpl/ptrhashtable_tpl.h"
 
 class karte_t;
 class test_driver_t;
 class grund_t;
+class way_graph_t;
 
 /**
  * Route, e.g. for vehicles
@@ -29,9 +35,16 @@ class route_t
 private:
 	/**
 	 * The actual route search
+	 * @param use_corridor long routes on water are first planned over clusters (see calc_corridor())
 	 * @author Hj. Malthaner
 	 */
-	bool intern_calc_route(karte_t *w, koord3d start, koord3d ziel, test_driver_t *tdriver, const sint32 max_kmh, const uint32 max_cost);
+	bool intern_calc_route(karte_t *w, koord3d start, koord3d ziel, test_driver_t *tdriver, const sint32 max_kmh, const uint32 max_cost, bool use_corridor = true);
+
+	/**
+	 * Same search as intern_calc_route(), but over the junctions of the way graph
+	 * instead of single tiles.
+	 */
+	bool intern_calc_graph_route(karte_t *w, way_graph_t *graph, koord3d start, koord3d ziel, test_driver_t *tdriver, const sint32 max_kmh, const uint32 max_cost);
 
 	koord3d_vector_t route;           // The coordinates for the vehicle route
 
@@ -58,23 +71,95 @@ public:
 		uint8 ribi_from; ///< we came from this direction
 		uint16 count;    ///< length of route up to here
 		uint8 jps_ribi;  ///< extra ribi mask for jump-point search
+		uint8 prev_dir;  ///< driving direction on the tile before (the parent may be far away in the way graph)
 
 		/// sort nodes first with respect to f, then with respect to g
 		inline bool operator <= (const ANode &k) const { return f==k.f ? g<=k.g : f<=k.f; }
 	};
 
-	static ANode *nodes;
-	static uint32 MAX_STEP;
-#ifdef DEBUG
-	// a semaphore, since we only have a single version of the array in memory
-	static bool node_in_use;
-	static void GET_NODE() {if(node_in_use){ dbg->fatal("GET_NODE","called while list in use");} node_in_use =1; }
-	static void RELEASE_NODE() {if(!node_in_use){ dbg->fatal("RELEASE_NODE","called while list free");} node_in_use =0; }
-#else
-	static void GET_NODE() {}
-	static void RELEASE_NODE() {}
+	/**
+	 * Everything a single search needs: node memory, open list and closed list.
+	 * There are several of them, so searches can run concurrently.
+	 */
+	class search_context_t {
+	public:
+		ANode *nodes;
+		binary_heap_tpl<ANode *> queue;
+		marker_t marker;
+		bool in_use;
+		uint8 slot;      ///< index in contexts, for data a search keeps in other places
+
+		/// flags of the clusters of the map for the coarse search, see calc_corridor()
+		uint8 *clusters;
+		uint32 cluster_count;
+		sint16 clusters_x, clusters_y;
+
+		search_context_t() : nodes(NULL), in_use(false), slot(0), clusters(NULL), cluster_count(0), clusters_x(0), clusters_y(0) {}
+		~search_context_t() { delete [] nodes; delete [] clusters; }
+
+		bool is_in_corridor(koord k) const;
+	};
+
+private:
+	/// one context per thread, allocated on first use
+	static search_context_t *contexts[MAX_THREADS];
+
+	/// a search done in advance by prepare_searches(), consumed by calc_route()
+	struct prepared_search_t {
+		test_driver_t *tdriver;
+		koord3d start, ziel;
+		sint32 max_speed;
+		bool ok;
+		route_t *result;
+	};
+	static vector_tpl<prepared_search_t> prepared_searches;
+	/// index of the first prepared search of a driver, so calc_route() need not scan all of them
+	static ptrhashtable_tpl<test_driver_t *, uint32> prepared_search_index;
+
+	static void run_prepared_search(karte_t *welt, prepared_search_t &search);
+
+	/**
+	 * @return true, if there is a tile at the border of cluster @p c in direction @p dir,
+	 * from which @p tdriver can enter the neighbouring cluster.
+	 */
+	static bool clusters_connected(karte_t *welt, test_driver_t *tdriver, koord c, ribi_t::ribi dir);
+
+	/**
+	 * Coarse search over square clusters of tiles between @p start and @p ziel.
+	 * All clusters along the coarse route and their neighbours are the corridor, in which the
+	 * tile search must stay. Clusters are connected, if any tile pair on their common border is.
+	 * @return false, if the clusters are not connected (hence there is no route at all)
+	 */
+	static bool calc_corridor(karte_t *welt, search_context_t *context, koord3d start, koord3d ziel, test_driver_t *tdriver);
+#ifdef MULTI_THREAD
+	static void prepared_search_thread(void *welt, int thread_num);
 #endif
 
+public:
+	static uint32 MAX_STEP;
+
+	/**
+	 * Reserves a free search context for the calling thread.
+	 * Must be returned with RELEASE_NODES() after the search.
+	 */
+	static search_context_t *GET_NODES(const karte_t *welt);
+	static void RELEASE_NODES(search_context_t *context);
+
+	/**
+	 * Queues a search for calc_route( welt, start, ziel, tdriver, max_speed, ... ).
+	 * The tdriver must only read the world during the search.
+	 */
+	static void add_prepared_search(test_driver_t *tdriver, koord3d start, koord3d ziel, sint32 max_speed);
+
+	/**
+	 * Does all queued searches, using env_t::num_threads threads.
+	 * The results do not depend on the number of threads, so this is safe in network games.
+	 */
+	static void prepare_searches(karte_t *welt);
+
+	/// discards all unused prepared searches
+	static void clear_prepared_searches();
+
 	const koord3d_vector_t &get_route() const { return route; }
 
 	void rotate90( sint16 y_size ) { route.rotate90( y_size ); };
@@ -168,6 +168,7 @@ settings_t::settings_t() :
 	max_transfers = 9;
 	max_hops = 2000;
 	no_routing_over_overcrowding = false;
+	halt_routing_table = false;
 
 	bonus_basefactor = 125;
 
@@ -775,6 +776,12 @@ void settings_t::rdwr(loadsave_t *file)
 		else if(  file->is_loading()  ) {
 			default_ai_construction_speed = env_t::default_ai_construction_speed;
 		}
+		if(  file->get_version()>=120003  ) {
+			file->rdwr_bool( halt_routing_table );
+		}
+		else if(  file->is_loading()  ) {
+			halt_routing_table = false;
+		}
 		// otherwise the default values of the last one will be used
 	}
 }
@@ -868,6 +875,8 @@ void settings_t::parse_simuconf(tabfile_t& simuconf, sint16& disp_width, sint16&
 	env_t::server_sync_steps_between_checks = contents.get_int("server_frames_between_checks", env_t::server_sync_steps_between_checks );
 	env_t::pause_server_no_clients = contents.get_int("pause_server_no_clients", env_t::pause_server_no_clients );
 	env_t::server_save_game_on_quit = contents.get_int("server_save_game_on_quit", env_t::server_save_game_on_quit );
+	env_t::server_checkpoint_interval = contents.get_int("server_checkpoint_interval", env_t::server_checkpoint_interval );
+	env_t::server_compress_frames = contents.get_int("server_compress_frames", env_t::server_compress_frames );
 
 	env_t::server_announce = contents.get_int("announce_server", env_t::server_announce );
 	env_t::server_announce = contents.get_int("server_announce", env_t::server_announce );
@@ -1052,6 +1061,7 @@ void settings_t::parse_simuconf(tabfile_t& simuconf, sint16& disp_width, sint16&
 	}
 
 	env_t::autosave = (contents.get_int("autosave", env_t::autosave) );
+	env_t::autosave_background = contents.get_int("autosave_background", env_t::autosave_background) != 0;
 
 	// routing stuff
 	max_route_steps = contents.get_int("max_route_steps", max_route_steps );
@@ -1079,6 +1089,7 @@ void settings_t::parse_simuconf(tabfile_t& simuconf, sint16& disp_width, sint16&
 	pay_for_total_distance = contents.get_int("pay_for_total_distance", pay_for_total_distance );
 	avoid_overcrowding = contents.get_int("avoid_overcrowding", avoid_overcrowding )!=0;
 	no_routing_over_overcrowding = contents.get_int("no_routing_over_overcrowded", no_routing_over_overcrowding )!=0;
+	halt_routing_table = contents.get_int("halt_routing_table", halt_routing_table )!=0;
 
 	// city stuff
 	passenger_multiplier = contents.get_int("passenger_multiplier", passenger_multiplier );
@@ -1337,6 +1348,12 @@ void settings_t::parse_simuconf(tabfile_t& simuconf, sint16& disp_width, sint16&
 	else if(strcmp(str, "xml_bzip2") == 0) {
 		loadsave_t::set_savemode(loadsave_t::xml_bzip2 );
 	}
+	else if(strcmp(str, "zipped_blocks") == 0) {
+		loadsave_t::set_savemode(loadsave_t::zipped_blocks );
+	}
+	else if(strcmp(str, "xml_zipped_blocks") == 0) {
+		loadsave_t::set_savemode(loadsave_t::xml_zipped_blocks );
+	}
 
 	str = contents.get("autosaveformat" );
 	while (*str == ' ') str++;
@@ -1358,6 +1375,12 @@ void settings_t::parse_simuconf(tabfile_t& simuconf, sint16& disp_width, sint16&
 	else if(strcmp(str, "xml_bzip2") == 0) {
 		loadsave_t::set_autosavemode(loadsave_t::xml_bzip2 );
 	}
+	else if(strcmp(str, "zipped_blocks") == 0) {
+		loadsave_t::set_autosavemode(loadsave_t::zipped_blocks );
+	}
+	else if(strcmp(str, "xml_zipped_blocks") == 0) {
+		loadsave_t::set_autosavemode(loadsave_t::xml_zipped_blocks );
+	}
 
 	/*
 	 * Default resolution
@@ -241,6 +241,9 @@ private:
 	/* if set, goods will not routed over overcrowded stations but rather try detours (if possible) */
 	bool no_routing_over_overcrowding;
 
+	/* if set, the routes between halts are precomputed per goods category and connected component */
+	bool halt_routing_table;
+
 	// lowest possible income with speedbonus (1000=1) default 125
 	sint32 bonus_basefactor;
 
@@ -470,6 +473,9 @@ public:
 	// do not allow routes over overcrowded destinations
 	bool is_no_routing_over_overcrowding() const { return no_routing_over_overcrowding; }
 
+	// route goods with precomputed tables instead of searching each packet
+	bool is_halt_routing_table() const { return halt_routing_table; }
+
 	sint16 get_river_number() const { return river_number; }
 	sint16 get_min_river_length() const { return min_river_length; }
 	sint16 get_max_river_length() const { return max_river_length; }
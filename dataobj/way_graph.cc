@@ -0,0 +1,271 @@
+/*
+ * This file is part of the Simutrans project under the artistic licence.
+ * (see licence.txt)
+ */
+
+#include "../simdebug.h"
+#include "../simworld.h"
+#include "../boden/grund.h"
+#include "../boden/wege/weg.h"
+#include "way_graph.h"
+
+
+karte_ptr_t way_graph_t::welt;
+
+way_graph_t *way_graph_t::graphs[narrowgauge_wt+1];
+
+
+way_graph_t::way_graph_t(waytype_t wt) :
+	wt(wt)
+{
+	cells_x = (welt->get_size().x >> CELL_SHIFT) + 1;
+	cells = new vector_tpl<edge_t *>[ cells_x * ((welt->get_size().y >> CELL_SHIFT) + 1) ];
+}
+
+
+way_graph_t::~way_graph_t()
+{
+	FOR(node_table_t, const& n, nodes) {
+		for(  uint8 i=0;  i<4;  i++  ) {
+			delete n.value->edges[i];
+		}
+		delete n.value;
+	}
+	for(  int i=0;  i<MAX_THREADS;  i++  ) {
+		FOR(vector_tpl<edge_t *>, const e, walked_edges[i]) {
+			delete e;
+		}
+	}
+	delete [] cells;
+}
+
+
+way_graph_t *way_graph_t::get_graph(waytype_t wt)
+{
+	switch(  wt  ) {
+		case road_wt:
+		case track_wt:
+		case monorail_wt:
+		case maglev_wt:
+		case tram_wt:
+		case narrowgauge_wt:
+			if(  graphs[wt] == NULL  ) {
+				graphs[wt] = new way_graph_t(wt);
+			}
+			return graphs[wt];
+
+		default:
+			// water and air have no ways to follow
+			return NULL;
+	}
+}
+
+
+bool way_graph_t::is_node(const grund_t *gr, waytype_t wt)
+{
+	if(  gr->has_two_ways()  ) {
+		return true;
+	}
+	const weg_t *w = gr->get_weg(wt);
+	if(  w == NULL  ||  w->has_sign()  ||  w->has_signal()  ||  w->is_crossing()  ) {
+		return true;
+	}
+	// only straight ways and curves are part of an edge
+	const ribi_t::ribi ribi = w->get_ribi();
+	return ribi != w->get_ribi_unmasked()  ||  !ribi_t::is_twoway(ribi);
+}
+
+
+way_graph_t::edge_t *way_graph_t::walk(const grund_t *gr, uint8 index) const
+{
+	ribi_t::ribi dir = ribi_t::nsow[index];
+	grund_t *to;
+	if(  !gr->get_neighbour(to, wt, dir)  ) {
+		return NULL;
+	}
+
+	edge_t *e = new edge_t();
+	e->start = gr->get_pos();
+	e->index = index;
+	e->min = e->max = gr->get_pos().get_2d();
+
+	while(  true  ) {
+		e->tiles.append( to );
+		const koord k = to->get_pos().get_2d();
+		e->min.x = min( e->min.x, k.x );
+		e->min.y = min( e->min.y, k.y );
+		e->max.x = max( e->max.x, k.x );
+		e->max.y = max( e->max.y, k.y );
+
+		if(  to == gr  ||  is_node(to, wt)  ||  e->tiles.get_count() >= 65000  ) {
+			// next junction or back at start on a closed loop
+			break;
+		}
+		// there is only one direction left (except where we came from)
+		dir = to->get_weg_ribi(wt) & ~ribi_t::rueckwaerts(dir);
+		grund_t *next;
+		if(  !ribi_t::ist_einfach(dir)  ||  !to->get_neighbour(next, wt, dir)  ) {
+			// broken way: the edge ends here
+			break;
+		}
+		to = next;
+	}
+	return e;
+}
+
+
+way_graph_t::node_t *way_graph_t::get_node(koord3d pos)
+{
+	node_t *n = nodes.get( pos );
+	if(  n == NULL  ) {
+		n = new node_t();
+		nodes.put( pos, n );
+	}
+	return n;
+}
+
+
+void way_graph_t::add_edge(node_t *n, uint8 index, edge_t *e)
+{
+	n->edges[index] = e;
+	n->built |= 1<<index;
+	if(  e  ) {
+		update_cells( e, true );
+	}
+}
+
+
+void way_graph_t::update_cells(edge_t *e, bool add)
+{
+	vector_tpl<edge_t *> *last = &get_cell( e->start.get_2d() );
+	if(  add  ) {
+		last->append( e );
+	}
+	else {
+		last->remove( e );
+	}
+	FOR(vector_tpl<grund_t *>, const gr, e->tiles) {
+		vector_tpl<edge_t *> *cell = &get_cell( gr->get_pos().get_2d() );
+		if(  cell != last  ) {
+			// an edge may enter a cell more than once
+			if(  add  ) {
+				cell->append_unique( e );
+			}
+			else {
+				cell->remove( e );
+			}
+			last = cell;
+		}
+	}
+}
+
+
+const way_graph_t::edge_t *way_graph_t::get_edge(const grund_t *gr, uint8 index)
+{
+	node_t *n = get_node( gr->get_pos() );
+	if(  (n->built & (1<<index)) == 0  ) {
+		add_edge( n, index, walk( gr, index ) );
+	}
+	return n->edges[index];
+}
+
+
+const way_graph_t::edge_t *way_graph_t::get_edge_parallel(const grund_t *gr, uint8 index, uint8 slot)
+{
+	const node_t *n = nodes.get( gr->get_pos() );
+	if(  n  &&  (n->built & (1<<index))  ) {
+		return n->edges[index];
+	}
+	edge_t *e = walk( gr, index );
+	if(  e  ) {
+		walked_edges[slot].append( e );
+	}
+	return e;
+}
+
+
+void way_graph_t::add_walked_edges()
+{
+	for(  int i=0;  i<=narrowgauge_wt;  i++  ) {
+		if(  way_graph_t *graph = graphs[i]  ) {
+			for(  int slot=0;  slot<MAX_THREADS;  slot++  ) {
+				FOR(vector_tpl<edge_t *>, const e, graph->walked_edges[slot]) {
+					node_t *n = graph->get_node( e->start );
+					if(  n->built & (1<<e->index)  ) {
+						// another search walked it too
+						delete e;
+					}
+					else {
+						graph->add_edge( n, e->index, e );
+					}
+				}
+				graph->walked_edges[slot].clear();
+			}
+		}
+	}
+}
+
+
+void way_graph_t::remove_edge(edge_t *e)
+{
+	if(  node_t *n = nodes.get( e->start )  ) {
+		if(  n->edges[e->index] == e  ) {
+			n->edges[e->index] = NULL;
+			n->built &= ~(1<<e->index);
+		}
+	}
+	update_cells( e, false );
+	delete e;
+}
+
+
+void way_graph_t::remove_tile(koord3d pos)
+{
+	// the node and everything leaving it
+	if(  node_t *n = nodes.remove( pos )  ) {
+		for(  uint8 i=0;  i<4;  i++  ) {
+			if(  n->edges[i]  ) {
+				update_cells( n->edges[i], false );
+				delete n->edges[i];
+			}
+		}
+		delete n;
+	}
+
+	// all edges passing or ending here are in the cell of this tile
+	const koord k = pos.get_2d();
+	vector_tpl<edge_t *> &cell = get_cell( k );
+	for(  uint32 i=cell.get_count();  i-- > 0;  ) {
+		edge_t *e = cell[i];
+		if(  k.x < e->min.x  ||  k.x > e->max.x  ||  k.y < e->min.y  ||  k.y > e->max.y  ) {
+			continue;
+		}
+		FOR(vector_tpl<grund_t *>, const gr, e->tiles) {
+			if(  gr->get_pos() == pos  ) {
+				// this moves only the entries after i, which are done already
+				remove_edge( e );
+				break;
+			}
+		}
+	}
+}
+
+
+void way_graph_t::invalidate(koord3d pos)
+{
+	// done at once, since the tiles of the edges may be deleted afterwards
+	for(  int i=0;  i<=narrowgauge_wt;  i++  ) {
+		if(  graphs[i]  &&  !graphs[i]->nodes.empty()  ) {
+			graphs[i]->remove_tile( pos );
+		}
+	}
+}
+
+
+void way_graph_t::reset()
+{
+	for(  int i=0;  i<=narrowgauge_wt;  i++  ) {
+		delete graphs[i];
+		graphs[i] = NULL;
+	}
+}
@@ -0,0 +1,152 @@
+/*
+ * This file is part of the Simutrans project under the artistic licence.
+ * (see licence.txt)
+ */
+
+#ifndef way_graph_h
+#define way_graph_h
+
+#include "../simtypes.h"
+#include "../simconst.h"
+#include "koord3d.h"
+#include "ribi.h"
+#include "../tpl/vector_tpl.h"
+#include "../tpl/hashtable_tpl.h"
+
+class grund_t;
+class karte_ptr_t;
+
+
+/**
+ * Compressed graph of a way network, so route searches can jump from junction to junction.
+ * Nodes are all tiles where a search may branch or must check something special:
+ * junctions, dead ends, signs, signals and crossings.
+ * Edges are the plain tiles with exactly two directions in between.
+ *
+ * Edges are built the first time a search leaves a node in their direction.
+ * Searches running in parallel only read the graph: they walk missing edges themselves,
+ * which are added to the graph by add_walked_edges() after all searches are done.
+ * Changing a way on a tile or deleting its ground forgets the node and all edges containing
+ * this tile, they will be built again on demand.
+ */
+class way_graph_t
+{
+public:
+	class edge_t {
+	public:
+		koord3d start;           ///< node this edge starts at
+		uint8 index;             ///< index of the direction (ribi_t::nsow) leaving the start node
+		koord min, max;          ///< bounding box of all tiles including start
+		vector_tpl<grund_t *> tiles; ///< all tiles after the start node, the last one is the end
+	};
+
+private:
+	class koord3d_hash_t {
+	public:
+		typedef sint32 diff_type;
+		static uint32 hash(const koord3d &k) { return (uint32)k.x*7 + (uint32)k.y*13 + (uint32)k.z; }
+		static void dump(const koord3d &k) { printf("%s", k.get_str()); }
+		static diff_type comp(const koord3d &a, const koord3d &b) {
+			return a.x!=b.x ? a.x-b.x : (a.y!=b.y ? a.y-b.y : a.z-b.z);
+		}
+	};
+
+	class node_t {
+	public:
+		edge_t *edges[4];
+		uint8 built;             ///< bit i set, if edges[i] is valid (may be NULL for no way)
+
+		node_t() : built(0) { edges[0] = edges[1] = edges[2] = edges[3] = NULL; }
+	};
+
+	static karte_ptr_t welt;
+
+	waytype_t wt;
+
+	typedef hashtable_tpl<koord3d, node_t *, koord3d_hash_t> node_table_t;
+	/// all edges of the graph belong to their start node
+	node_table_t nodes;
+
+	/// edges of the searches running in parallel, by their search context; see get_edge_parallel()
+	vector_tpl<edge_t *> walked_edges[MAX_THREADS];
+
+	/**
+	 * The map is divided into square cells of 2^CELL_SHIFT tiles. Each cell has a list of the edges
+	 * with tiles in it, so a changed tile needs only to check the edges of its cell.
+	 */
+	enum { CELL_SHIFT = 4 };
+	vector_tpl<edge_t *> *cells;
+	uint32 cells_x;
+
+	vector_tpl<edge_t *> &get_cell(koord k) const { return cells[ (uint32)(k.y >> CELL_SHIFT) * cells_x + (uint32)(k.x >> CELL_SHIFT) ]; }
+
+	way_graph_t(waytype_t wt);
+	~way_graph_t();
+
+	/// @return the node on this tile, a new one if there was none
+	node_t *get_node(koord3d pos);
+
+	/// enters this edge (may be NULL for no way) as edge @p index of the node @p n
+	void add_edge(node_t *n, uint8 index, edge_t *e);
+
+	/// enters or removes the edge in the cells of its tiles
+	void update_cells(edge_t *e, bool add);
+
+	/// remove and delete this edge
+	void remove_edge(edge_t *e);
+
+	/// forgets everything containing this tile
+	void remove_tile(koord3d pos);
+
+	static way_graph_t *graphs[narrowgauge_wt+1];
+
+public:
+	/**
+	 * @return the graph for this waytype, or NULL if routes of this waytype are searched tile by tile
+	 * The graph is created on the first call, so this must not happen during parallel searches.
+	 */
+	static way_graph_t *get_graph(waytype_t wt);
+
+	waytype_t get_waytype() const { return wt; }
+
+	/**
+	 * @return true, if a search must stop on this tile (i.e. the tile is not part of an edge)
+	 */
+	static bool is_node(const grund_t *gr, waytype_t wt);
+
+	/**
+	 * @return edge leaving the node @p gr in the direction ribi_t::nsow[@p index]
+	 * NULL if there is no way into this direction. The edge is built on first use.
+	 */
+	const edge_t *get_edge(const grund_t *gr, uint8 index);
+
+	/**
+	 * Like get_edge(), but does not change the graph, so any number of searches may call it at once.
+	 * A missing edge is walked and kept in the list of the search context @p slot until add_walked_edges().
+	 */
+	const edge_t *get_edge_parallel(const grund_t *gr, uint8 index, uint8 slot);
+
+	/**
+	 * Adds the edges walked by get_edge_parallel() to their graphs, once all parallel searches are done.
+	 */
+	static void add_walked_edges();
+
+	/**
+	 * Walks from @p gr into direction ribi_t::nsow[@p index] up to the next node.
+	 * Used for start and end tiles, which are not nodes. The caller must delete the result.
+	 */
+	edge_t *walk(const grund_t *gr, uint8 index) const;
+
+	/**
+	 * The way on this tile has changed: forget all nodes and edges containing it.
+	 * Must not be called while searches are running.
+	 */
+	static void invalidate(koord3d pos);
+
+	/**
+	 * Forgets all graphs, e.g. for a new map or after rotation.
+	 */
+	static void reset();
+};
+
+#endif
@@ -155,6 +155,18 @@ uint16 display_load_font(const char* fname);
 image_id get_image_count();
 void register_image(struct bild_t*);
 
+/// memory used by the images in bytes
+struct image_memory_t {
+	image_id count;     ///< number of images
+	size_t base;        ///< pixels as loaded from the paks
+	size_t zoomed;      ///< pixels of the current zoom level
+	size_t recoded;     ///< pixels converted to the screen colours without player colours
+	size_t chunks;      ///< allocated for zoomed and recoded, including unused parts
+	size_t player;      ///< copies with player colours
+	size_t descriptors; ///< the image table itself
+};
+void display_get_image_memory(image_memory_t *mem);
+
 // delete all images above a certain number ...
 void display_free_all_images_above( image_id above );
 
@@ -178,6 +190,22 @@ void mark_rect_dirty_clip(KOORD_VAL x1, KOORD_VAL y1, KOORD_VAL x2, KOORD_VAL y2
 #endif
 void mark_screen_dirty();
 
+/**
+ * The world is drawn into its own buffer, which is kept between frames, so only changed parts must be drawn again.
+ * Starts drawing into this buffer.
+ * @param rects filled with the areas to draw: the dirty tiles of this and the last frame between @p y and @p y+h,
+ *        must be kept until display_world_end()
+ * @param redraw_all draw everything, e.g. after the background was cleared
+ * @return number of rectangles in @p rects, at most @p max_rects
+ */
+int display_world_begin(scr_rect *rects, int max_rects, KOORD_VAL y, KOORD_VAL h, bool redraw_all);
+
+/**
+ * Copies the areas drawn again and the ones drawn over since the last frame from the world to the screen buffer.
+ * Everything drawn afterwards goes to the screen buffer again.
+ */
+void display_world_end();
+
 KOORD_VAL display_get_width();
 KOORD_VAL display_get_height();
 void      display_set_height(KOORD_VAL);
@@ -60,6 +60,15 @@ void mark_screen_dirty()
 {
 }
 
+int display_world_begin(scr_rect *, int, KOORD_VAL, KOORD_VAL, bool)
+{
+	return 0;
+}
+
+void display_world_end()
+{
+}
+
 void display_mark_img_dirty(image_id, KOORD_VAL, KOORD_VAL)
 {
 }
@@ -498,6 +507,11 @@ image_id get_image_count()
 	return 0;
 }
 
+void display_get_image_memory(image_memory_t *mem)
+{
+	*mem = image_memory_t();
+}
+
 #ifdef MULTI_THREAD
 void add_poly_clip(int, int, int, int, int, const sint8)
 {
@@ -22,8 +22,11 @@
 #include "../unicode.h"
 #include "../simticker.h"
 #include "../utils/simstring.h"
+#include "../tpl/vector_tpl.h"
 #include "simgraph.h"
 
+#include <algorithm>
+
 
 #ifdef _MSC_VER
 #	include <io.h>
@@ -50,6 +53,15 @@
 # endif
 #endif
 
+// vectorised blend and alpha routines: GCC and clang map vectors of 8 pixels onto SSE2 or NEON
+#if defined(__GNUC__)  &&  (defined(__SSE2__)  ||  defined(__ARM_NEON)  ||  defined(__ARM_NEON__))
+#	define USE_PIXVEC
+// ... and vectors of 16 pixels onto AVX2, if the cpu has it
+#	if defined(__x86_64__)  ||  defined(__i386__)
+#		define USE_PIXVEC_AVX2
+#	endif
+#endif
+
 #ifdef MULTI_THREAD
 #include "../utils/simthread.h"
 
@@ -346,6 +358,8 @@ struct imd {
 	uint16 player_flags; // bit # is player number, ==1 cache image needs recoding
 
 	PIXVAL* data[MAX_PLAYER_COUNT]; // current data - zoomed and recolored (player + daynight)
+	uint32 drawn_frame; // last frame this image was drawn, to find the least recently used
+	bool in_player_data_images; // may have data[1..]
 
 	PIXVAL* zoom_data; // zoomed original data
 	uint32 len;    // current zoom image data size (or base if not zoomed) (used for allocation purposes only)
@@ -387,6 +401,110 @@ static struct imd* images = NULL;
  */
 static image_id anz_images = 0;
 
+/*
+ * Zoomed and recoded image data (zoom_data and data[0]) is not allocated image by image but from large chunks.
+ * Each chunk counts its allocations and is freed together with the last one. Since all images are
+ * rezoomed after a zoom change, the chunks of the old zoom level become empty.
+ * The player coloured copies are freed in any order by their cache, so they still use malloc.
+ */
+#define IMAGE_CHUNK_SIZE (1024*1024)
+
+struct image_chunk_t {
+	size_t size;  // bytes following this header
+	size_t used;  // bytes given out
+	uint32 count; // allocations not freed yet
+};
+
+// the chunk for the next allocations
+static image_chunk_t *image_chunk = NULL;
+
+// bytes of all chunks (including their unused parts)
+static size_t image_chunk_memory = 0;
+
+#ifdef MULTI_THREAD
+static pthread_mutex_t image_chunk_mutex = PTHREAD_MUTEX_INITIALIZER;
+#endif
+
+
+static PIXVAL *image_data_alloc(uint32 len)
+{
+	// each allocation starts with a pointer to its chunk
+	size_t bytes = sizeof(image_chunk_t *) + len * sizeof(PIXVAL);
+	bytes = (bytes + sizeof(image_chunk_t *) - 1) & ~(sizeof(image_chunk_t *) - 1);
+#ifdef MULTI_THREAD
+	pthread_mutex_lock( &image_chunk_mutex );
+#endif
+	image_chunk_t *chunk = image_chunk;
+	if(  chunk == NULL  ||  chunk->used + bytes > chunk->size  ) {
+		// large images get a chunk of their own, so the rest of the current one is not wasted
+		const size_t size = bytes > IMAGE_CHUNK_SIZE/4 ? bytes : IMAGE_CHUNK_SIZE;
+		chunk = (image_chunk_t *)xmalloc( sizeof(image_chunk_t) + size );
+		chunk->size = size;
+		chunk->used = 0;
+		chunk->count = 0;
+		image_chunk_memory += sizeof(image_chunk_t) + size;
+		if(  size == IMAGE_CHUNK_SIZE  ) {
+			if(  image_chunk != NULL  &&  image_chunk->count == 0  ) {
+				image_chunk_memory -= sizeof(image_chunk_t) + image_chunk->size;
+				guarded_free( image_chunk );
+			}
+			image_chunk = chunk;
+		}
+	}
+	image_chunk_t **p = (image_chunk_t **)((uint8 *)(chunk + 1) + chunk->used);
+	*p = chunk;
+	chunk->used += bytes;
+	chunk->count++;
+#ifdef MULTI_THREAD
+	pthread_mutex_unlock( &image_chunk_mutex );
+#endif
+	return (PIXVAL *)(p + 1);
+}
+
+
+static void image_data_free(PIXVAL *data)
+{
+	image_chunk_t *chunk = ((image_chunk_t **)data)[-1];
+#ifdef MULTI_THREAD
+	pthread_mutex_lock( &image_chunk_mutex );
+#endif
+	if(  --chunk->count == 0  ) {
+		if(  chunk == image_chunk  ) {
+			// start again from the beginning
+			chunk->used = 0;
+		}
+		else {
+			image_chunk_memory -= sizeof(image_chunk_t) + chunk->size;
+			guarded_free( chunk );
+		}
+	}
+#ifdef MULTI_THREAD
+	pthread_mutex_unlock( &image_chunk_mutex );
+#endif
+}
+
+
+/*
+ * The player coloured copies (data[1..]) share this memory budget,
+ * the least recently drawn are freed at the end of a frame when it is exceeded
+ */
+#define PLAYER_DATA_BUDGET (32*1024*1024)
+
+// bytes allocated for data[1..] of all images
+static size_t player_data_size = 0;
+
+// all images which may have player coloured copies
+static vector_tpl<image_id> player_data_images;
+
+// counts the frames for imd::drawn_frame
+static uint32 display_frame = 0;
+
+/*
+ * After a light change the images are recoded lazily when drawn, but at most this many pixels per frame.
+ * The remaining images are drawn with the colours before the change until their turn.
+ */
+static sint32 recode_budget = 0;
+
 /*
  * Number of allocated entries for images
  * (>= anz_images)
@@ -399,6 +517,22 @@ static image_id alloc_images = 0;
  */
 static PIXVAL* textur = NULL;
 
+/*
+ * The world is drawn into its own buffer, which keeps its contents between frames.
+ * Only the dirty parts are drawn again, see display_world_begin()
+ */
+static PIXVAL* world_textur = NULL;
+static PIXVAL* screen_textur = NULL; // textur while the world is drawn
+static KOORD_VAL world_width = 0, world_height = 0;
+static KOORD_VAL world_y = 0, world_h = 0;
+
+// the areas drawn again, only these are copied to the screen buffer
+static const scr_rect *world_rects = NULL;
+static int world_rect_count = 0;
+
+// some images were drawn with the old colours, so the world must be drawn again
+static bool recode_pending = false;
+
 
 /*
  * Hajo: dirty tile management structures
@@ -409,6 +543,10 @@ static PIXVAL* textur = NULL;
 static uint32 *tile_dirty = NULL;
 static uint32 *tile_dirty_old = NULL;
 
+// tiles of the screen buffer drawn over the world without marking them dirty (e.g. the station coverage),
+// the world is copied there again in the next frame
+static uint32 *tile_overdrawn = NULL;
+
 static int tiles_per_line = 0;
 static int tile_buffer_per_line = 0; // number of tiles that fit the allocated buffer per line - maintain alignment - x=0 is always first bit in a word for each row
 static int tile_lines = 0;
@@ -1032,6 +1170,41 @@ static void mark_rect_dirty_nc(KOORD_VAL x1, KOORD_VAL y1, KOORD_VAL x2, KOORD_V
 }
 
 
+/**
+ * Something was drawn over the world in the screen buffer without marking it dirty.
+ * Dirty areas are drawn again in the next frame anyway.
+ */
+static void mark_rect_overdrawn(KOORD_VAL x1, KOORD_VAL y1, KOORD_VAL x2, KOORD_VAL y2)
+{
+	if(  textur == world_textur  ) {
+		// drawing the world itself
+		return;
+	}
+	if(  x1 < 0  ) {
+		x1 = 0;
+	}
+	if(  x2 >= disp_width  ) {
+		x2 = disp_width - 1;
+	}
+	if(  y1 < world_y  ) {
+		y1 = world_y;
+	}
+	if(  y2 >= min( world_y + world_h, (int)disp_height )  ) {
+		y2 = min( world_y + world_h, (int)disp_height ) - 1;
+	}
+	if(  x1 > x2  ||  y1 > y2  ) {
+		return;
+	}
+	for(  int y = y1 >> DIRTY_TILE_SHIFT;  y <= (y2 >> DIRTY_TILE_SHIFT);  y++  ) {
+		int bit = y * tile_buffer_per_line + (x1 >> DIRTY_TILE_SHIFT);
+		const int end = y * tile_buffer_per_line + (x2 >> DIRTY_TILE_SHIFT);
+		do {
+			((uint8*)tile_overdrawn)[bit >> 3] |= 1 << (bit & 7);
+		} while(  ++bit <= end  );
+	}
+}
+
+
 /**
  * Mark tile as dirty, with clipping
  * @author Hj. Malthaner
@@ -1110,6 +1283,146 @@ void mark_screen_dirty()
 }
 
 
+int display_world_begin(scr_rect *rects, int max_rects, KOORD_VAL y, KOORD_VAL h, bool redraw_all)
+{
+	if(  world_textur == NULL  ||  world_width != disp_width  ||  world_height != disp_height  ) {
+		guarded_free( world_textur );
+		world_width = disp_width;
+		world_height = disp_height;
+		world_textur = MALLOCN( PIXVAL, world_width * world_height );
+		redraw_all = true;
+	}
+	if(  recode_pending  ) {
+		// the images with old colours are also still on screen
+		mark_screen_dirty();
+		recode_pending = false;
+		redraw_all = true;
+	}
+	if(  y < 0  ) {
+		h += y;
+		y = 0;
+	}
+	h = min( h, disp_height - y );
+	if(  world_y != y  ||  world_h != h  ) {
+		// e.g. the ticker appeared: nothing was drawn there yet
+		world_y = y;
+		world_h = h;
+		redraw_all = true;
+	}
+
+	screen_textur = textur;
+	textur = world_textur;
+	world_rects = rects;
+	world_rect_count = 0;
+
+	if(  h <= 0  ) {
+		return 0;
+	}
+	if(  redraw_all  ) {
+		rects[0] = scr_rect( 0, y, disp_width, h );
+		world_rect_count = 1;
+		return 1;
+	}
+
+	// the dirty tiles of a line make one rectangle, which is joined with the ones of close lines
+	const int words_per_line = tile_buffer_per_line >> 5;
+	const int last_line = (y + h - 1) >> DIRTY_TILE_SHIFT;
+	int count = 0;
+	for(  int line = y >> DIRTY_TILE_SHIFT;  line <= last_line;  line++  ) {
+		int x1 = -1, x2 = -1;
+		for(  int i = line * words_per_line;  i < (line + 1) * words_per_line;  i++  ) {
+			const uint32 bits = tile_dirty[i] | tile_dirty_old[i];
+			if(  bits  ) {
+				int bit = 0;
+				if(  x1 < 0  ) {
+					while(  (bits & (1u << bit)) == 0  ) {
+						bit++;
+					}
+					x1 = ((i - line * words_per_line) << 5) + bit;
+				}
+				bit = 31;
+				while(  (bits & (1u << bit)) == 0  ) {
+					bit--;
+				}
+				x2 = ((i - line * words_per_line) << 5) + bit;
+			}
+		}
+		if(  x1 < 0  ) {
+			continue;
+		}
+
+		const KOORD_VAL xp = x1 << DIRTY_TILE_SHIFT;
+		const KOORD_VAL right = min( (x2 + 1) << DIRTY_TILE_SHIFT, (int)disp_width );
+		const KOORD_VAL yp = max( line << DIRTY_TILE_SHIFT, (int)y );
+		const KOORD_VAL bottom = min( (line + 1) << DIRTY_TILE_SHIFT, y + h );
+		scr_rect *const r = count > 0 ? &rects[count - 1] : NULL;
+		if(  r  &&  (r->get_bottom() + 2 * DIRTY_TILE_SIZE >= yp  ||  count == max_rects)  ) {
+			// close enough (or no rectangles left): enlarge the last one
+			const KOORD_VAL r_right = max( r->get_right(), right );
+			r->x = min( r->x, xp );
+			r->set_right( r_right );
+			r->set_bottom( bottom );
+		}
+		else {
+			rects[count++] = scr_rect( xp, yp, right - xp, bottom - yp );
+		}
+	}
+	world_rect_count = count;
+	return count;
+}
+
+
+// copies the pixels x1..x2-1 of the lines y1..y2-1 from the world to the screen buffer
+static void copy_world_rect(KOORD_VAL x1, KOORD_VAL y1, KOORD_VAL x2, KOORD_VAL y2)
+{
+	for(  KOORD_VAL y = y1;  y < y2;  y++  ) {
+		const int offset = y * disp_width + x1;
+		memcpy( textur + offset, world_textur + offset, sizeof(PIXVAL) * (x2 - x1) );
+	}
+}
+
+
+void display_world_end()
+{
+	textur = screen_textur;
+	if(  world_h <= 0  ) {
+		return;
+	}
+	// the world has changed only in the areas drawn again
+	for(  int r = 0;  r < world_rect_count;  r++  ) {
+		const scr_rect &rect = world_rects[r];
+		copy_world_rect( rect.x, rect.y, rect.get_right(), rect.get_bottom() );
+	}
+	world_rect_count = 0;
+
+	// and there are the overlays of the last frame to remove
+	const int words_per_line = tile_buffer_per_line >> 5;
+	const int last_line = (world_y + world_h - 1) >> DIRTY_TILE_SHIFT;
+	for(  int line = world_y >> DIRTY_TILE_SHIFT;  line <= last_line;  line++  ) {
+		const KOORD_VAL y1 = max( line << DIRTY_TILE_SHIFT, (int)world_y );
+		const KOORD_VAL y2 = min( (line + 1) << DIRTY_TILE_SHIFT, world_y + world_h );
+		const uint32 *bits = tile_overdrawn + line * words_per_line;
+		int x1 = -1;
+		for(  int x = 0;  x <= tiles_per_line;  x++  ) {
+			if(  x1 < 0  &&  (x & 31) == 0  &&  x < tiles_per_line  &&  bits[x >> 5] == 0  ) {
+				// nothing in this word
+				x += 31;
+				continue;
+			}
+			const bool set = x < tiles_per_line  &&  (bits[x >> 5] & (1u << (x & 31)));
+			if(  set  &&  x1 < 0  ) {
+				x1 = x;
+			}
+			else if(  !set  &&  x1 >= 0  ) {
+				copy_world_rect( x1 << DIRTY_TILE_SHIFT, y1, min( x << DIRTY_TILE_SHIFT, (int)disp_width ), y2 );
+				x1 = -1;
+			}
+		}
+	}
+	MEMZERON( tile_overdrawn, tile_buffer_length );
+}
+
+
 /**
  * the area of this image need update
  * @author Hj. Malthaner
@@ -1148,14 +1461,25 @@ static void rezoom()
 }
 
 
+#ifdef MULTI_THREAD
+static void stop_rezoom_background();
+static void resume_rezoom_background(bool restart);
+#else
+#define stop_rezoom_background()
+#define resume_rezoom_background(restart)
+#endif
+
+
 void set_zoom_factor(int z)
 {
 	// do not zoom beyond 4 pixels
 	if(  (base_tile_raster_width * zoom_num[z]) / zoom_den[z] > 4  ) {
+		stop_rezoom_background();
 		zoom_factor = z;
 		tile_raster_width = (base_tile_raster_width * zoom_num[zoom_factor]) / zoom_den[zoom_factor];
 		fprintf(stderr, "set_zoom_factor() : set %d (%i/%i)\n", zoom_factor, zoom_num[zoom_factor], zoom_den[zoom_factor] );
 		rezoom();
+		resume_rezoom_background( true );
 	}
 }
 
@@ -1256,6 +1580,46 @@ image_id get_image_count()
 }
 
 
+/**
+ * @return length of the RLE data in PIXVAL
+ */
+static uint32 get_image_len(const PIXVAL *data, sint16 h)
+{
+	const PIXVAL *sp = data;
+	while(  h-- > 0  ) {
+		do {
+			// clear run + colored run + next clear run
+			sp++;
+			sp += *sp + 1;
+		} while(  *sp  );
+		sp++;
+	}
+	return (uint32)(size_t)(sp - data);
+}
+
+
+void display_get_image_memory(image_memory_t *mem)
+{
+	// no locking, this is only for information
+	mem->count = anz_images;
+	mem->base = 0;
+	mem->zoomed = 0;
+	mem->recoded = 0;
+	for(  image_id n = 0;  n < anz_images;  n++  ) {
+		mem->base += get_image_len( images[n].base_data, images[n].base_h ) * sizeof(PIXVAL);
+		if(  images[n].zoom_data != NULL  ) {
+			mem->zoomed += images[n].len * sizeof(PIXVAL);
+		}
+		if(  images[n].data[0] != NULL  ) {
+			mem->recoded += images[n].len * sizeof(PIXVAL);
+		}
+	}
+	mem->chunks = image_chunk_memory;
+	mem->player = player_data_size;
+	mem->descriptors = alloc_images * sizeof(imd);
+}
+
+
 /**
  * Handles the conversion of an image to the output color
  * @author prissi
@@ -1271,15 +1635,94 @@ static void recode_img(const image_id n, const sint8 player_nr)
 		return;
 	}
 #endif
+	if(  recode_budget <= 0  &&  images[n].data[player_nr] != NULL  ) {
+		// enough recoded this frame, the old colours will do until the next one
+		recode_pending = true;
+#ifdef MULTI_THREAD
+		pthread_mutex_unlock( &recode_img_mutex );
+#endif
+		return;
+	}
 	PIXVAL *src = images[n].zoom_data != NULL ? images[n].zoom_data : images[n].base_data;
 
 	if(  images[n].data[player_nr] == NULL  ) {
-		images[n].data[player_nr] = MALLOCN( PIXVAL, images[n].len );
+		images[n].data[player_nr] = player_nr == 0 ? image_data_alloc( images[n].len ) : MALLOCN( PIXVAL, images[n].len );
+		if(  player_nr > 0  ) {
+			player_data_size += images[n].len * sizeof(PIXVAL);
+			if(  !images[n].in_player_data_images  ) {
+				images[n].in_player_data_images = true;
+				player_data_images.append( n );
+			}
+		}
 	}
 	// contains now the player color ...
 	activate_player_color( player_nr, true );
 	recode_img_src_target( images[n].h, src, images[n].data[player_nr] );
 	images[n].player_flags &= ~(1<<player_nr);
+	recode_budget -= images[n].len;
+#ifdef MULTI_THREAD
+	pthread_mutex_unlock( &recode_img_mutex );
+#endif
+}
+
+
+/**
+ * Frees the player coloured copies of an image
+ * (must hold recode_img_mutex in multithreaded code)
+ */
+static void free_player_data(const image_id n)
+{
+	for(  uint8 i = 1;  i < MAX_PLAYER_COUNT;  i++  ) {
+		if(  images[n].data[i] != NULL  ) {
+			guarded_free( images[n].data[i] );
+			images[n].data[i] = NULL;
+			images[n].player_flags |= 1<<i;
+			player_data_size -= images[n].len * sizeof(PIXVAL);
+		}
+	}
+}
+
+
+static bool compare_drawn_frame(const image_id a, const image_id b)
+{
+	return images[a].drawn_frame < images[b].drawn_frame;
+}
+
+
+/**
+ * Called between frames: frees the least recently drawn player coloured copies
+ * down to 3/4 of the budget and resets the recode budget for the next frame.
+ */
+static void update_image_caches()
+{
+	display_frame++;
+	recode_budget = disp_width * disp_height;
+
+	if(  player_data_size <= PLAYER_DATA_BUDGET  ) {
+		return;
+	}
+#ifdef MULTI_THREAD
+	// rezoom_img() may free copies too
+	pthread_mutex_lock( &recode_img_mutex );
+#endif
+	std::sort( player_data_images.begin(), player_data_images.end(), compare_drawn_frame );
+	uint32 i = 0;
+	// the copies of the last frame are kept in any case, they will be needed again
+	for(  ;  i < player_data_images.get_count()  &&  player_data_size > PLAYER_DATA_BUDGET/4*3;  i++  ) {
+		const image_id n = player_data_images[i];
+		if(  images[n].drawn_frame + 1 >= display_frame  ) {
+			break;
+		}
+		free_player_data( n );
+		images[n].in_player_data_images = false;
+	}
+	// now remove them from the list
+	for(  uint32 j = i;  j < player_data_images.get_count();  j++  ) {
+		player_data_images[j-i] = player_data_images[j];
+	}
+	while(  i-- > 0  ) {
+		player_data_images.pop_back();
+	}
 #ifdef MULTI_THREAD
 	pthread_mutex_unlock( &recode_img_mutex );
 #endif
@@ -1364,15 +1807,20 @@ static void rezoom_img(const image_id n)
 		//  we recalculate the len (since it may be larger than before)
 		// thus we have to free the old caches
 		if(  images[n].zoom_data != NULL  ) {
-			guarded_free( images[n].zoom_data );
+			image_data_free( images[n].zoom_data );
 			images[n].zoom_data = NULL;
 		}
-		for(  uint8 i = 0;  i < MAX_PLAYER_COUNT;  i++  ) {
-			if(  images[n].data[i] != NULL  ) {
-				guarded_free( images[n].data[i] );
-				images[n].data[i] = NULL;
-			}
+#ifdef MULTI_THREAD
+		pthread_mutex_lock( &recode_img_mutex );
+#endif
+		if(  images[n].data[0] != NULL  ) {
+			image_data_free( images[n].data[0] );
+			images[n].data[0] = NULL;
 		}
+		free_player_data( n );
+#ifdef MULTI_THREAD
+		pthread_mutex_unlock( &recode_img_mutex );
+#endif
 
 		// just restore original size?
 		if(  zoom_factor == ZOOM_NEUTRAL  ||  (images[n].recode_flags&FLAG_ZOOMABLE) == 0  ) {
@@ -1381,19 +1829,7 @@ static void rezoom_img(const image_id n)
 			images[n].w = images[n].base_w;
 			images[n].y = images[n].base_y;
 			images[n].h = images[n].base_h;
-			// recalculate length
-			sint16 h = images[n].base_h;
-			PIXVAL *sp = images[n].base_data;
-
-			while(  h-- > 0  ) {
-				do {
-					// clear run + colored run + next clear run
-					sp++;
-					sp += *sp + 1;
-				} while(  *sp  );
-				sp++;
-			}
-			images[n].len = (uint32)(size_t)(sp - images[n].base_data);
+			images[n].len = get_image_len( images[n].base_data, images[n].base_h );
 			images[n].recode_flags &= ~FLAG_REZOOM;
 #ifdef MULTI_THREAD
 			pthread_mutex_unlock( &rezoom_img_mutex[n % env_t::num_threads] );
@@ -1783,8 +2219,7 @@ static void rezoom_img(const image_id n)
 			if(  newzoomheight > 0  ) {
 				const size_t zoom_len = (size_t)(((uint8 *)dest) - ((uint8 *)rezoom_baseimage[n % env_t::num_threads]));
 				images[n].len = (uint32)(zoom_len / sizeof(PIXVAL));
-				images[n].zoom_data = MALLOCN(PIXVAL, images[n].len);
-				assert( images[n].zoom_data );
+				images[n].zoom_data = image_data_alloc( images[n].len );
 				memcpy( images[n].zoom_data, rezoom_baseimage[n % env_t::num_threads], zoom_len );
 			}
 		}
@@ -1803,6 +2238,126 @@ static void rezoom_img(const image_id n)
 }
 
 
+#ifdef MULTI_THREAD
+/*
+ * After a zoom change, a background thread rezooms all images, first those drawn in the last frame,
+ * then the rest, which may be needed when scrolling. The drawing still calls rezoom_img() for images
+ * not done yet; the per-image mutex in rezoom_img() keeps both apart.
+ * The thread touches images only while rezoom_background_busy is set. Everything that changes
+ * the images or the zoom factor must call stop_rezoom_background() first, which waits for that.
+ */
+static pthread_mutex_t rezoom_background_mutex = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t rezoom_background_work_cond = PTHREAD_COND_INITIALIZER;
+static pthread_cond_t rezoom_background_idle_cond = PTHREAD_COND_INITIALIZER;
+static pthread_t rezoom_background_thread;
+static bool rezoom_background_started = false;
+
+// all following variables are protected by rezoom_background_mutex
+static int rezoom_background_stopped = 0;
+static bool rezoom_background_busy = false;
+static bool rezoom_background_quit = false;
+// changed by every zoom change, makes the thread start over
+static uint32 rezoom_background_generation = 0;
+// images drawn after this frame are rezoomed first
+static uint32 rezoom_background_frame = 0;
+
+
+static void *rezoom_background_run(void *)
+{
+	uint32 generation = 0;
+	uint32 frame = 0;
+	image_id n = 0;
+	bool drawn_only = true;
+	bool done = true;
+
+	pthread_mutex_lock( &rezoom_background_mutex );
+	while(  true  ) {
+		while(  !rezoom_background_quit  &&  (rezoom_background_stopped > 0  ||  (done  &&  generation == rezoom_background_generation))  ) {
+			pthread_cond_wait( &rezoom_background_work_cond, &rezoom_background_mutex );
+		}
+		if(  rezoom_background_quit  ) {
+			break;
+		}
+		if(  generation != rezoom_background_generation  ) {
+			generation = rezoom_background_generation;
+			frame = rezoom_background_frame;
+			n = 0;
+			drawn_only = true;
+			done = false;
+		}
+		rezoom_background_busy = true;
+		pthread_mutex_unlock( &rezoom_background_mutex );
+
+		// at most one image per round, so stop_rezoom_background() never waits long
+		while(  n < anz_images  ) {
+			const image_id i = n++;
+			if(  (images[i].recode_flags & FLAG_REZOOM)  &&  (images[i].drawn_frame + 1 >= frame) == drawn_only  ) {
+				rezoom_img( i );
+				break;
+			}
+		}
+		if(  n >= anz_images  ) {
+			if(  drawn_only  ) {
+				n = 0;
+				drawn_only = false;
+			}
+			else {
+				done = true;
+			}
+		}
+
+		pthread_mutex_lock( &rezoom_background_mutex );
+		rezoom_background_busy = false;
+		if(  rezoom_background_stopped > 0  ) {
+			pthread_cond_broadcast( &rezoom_background_idle_cond );
+		}
+	}
+	pthread_mutex_unlock( &rezoom_background_mutex );
+	return NULL;
+}
+
+
+/**
+ * Waits until the background thread does not touch any image any more
+ */
+static void stop_rezoom_background()
+{
+	pthread_mutex_lock( &rezoom_background_mutex );
+	rezoom_background_stopped++;
+	while(  rezoom_background_busy  ) {
+		pthread_cond_wait( &rezoom_background_idle_cond, &rezoom_background_mutex );
+	}
+	pthread_mutex_unlock( &rezoom_background_mutex );
+}
+
+
+/**
+ * Lets the background thread continue; with restart it starts over with the images flagged by rezoom()
+ */
+static void resume_rezoom_background(bool restart)
+{
+	pthread_mutex_lock( &rezoom_background_mutex );
+	rezoom_background_stopped--;
+	if(  restart  &&  env_t::num_threads > 1  ) {
+		if(  !rezoom_background_started  ) {
+			if(  pthread_create( &rezoom_background_thread, NULL, rezoom_background_run, NULL )  ) {
+				dbg->error( "resume_rezoom_background()", "cannot start thread, images are rezoomed when drawn" );
+			}
+			else {
+				rezoom_background_started = true;
+			}
+		}
+		rezoom_background_generation++;
+		rezoom_background_frame = display_frame;
+	}
+	if(  rezoom_background_stopped == 0  ) {
+		pthread_cond_broadcast( &rezoom_background_work_cond );
+	}
+	pthread_mutex_unlock( &rezoom_background_mutex );
+}
+#endif
+
+
 // force a certain size on a image (for rescaling tool images)
 void display_fit_img_to_width( const image_id n, sint16 new_w )
 {
@@ -1811,6 +2366,8 @@ void display_fit_img_to_width( const image_id n, sint16 new_w )
 		for(  int i=0;  i<=MAX_ZOOM_FACTOR;  i++  ) {
 			int zoom_w = (images[n].base_w * zoom_num[i]) / zoom_den[i];
 			if(  zoom_w <= new_w  ) {
+				// the background thread must not see the changed zoom factor
+				stop_rezoom_background();
 				uint8 old_zoom_flag = images[n].recode_flags & FLAG_ZOOMABLE;
 				images[n].recode_flags |= FLAG_REZOOM | FLAG_ZOOMABLE;
 				zoom_factor = i;
@@ -1818,6 +2375,7 @@ void display_fit_img_to_width( const image_id n, sint16 new_w )
 				images[n].recode_flags &= ~FLAG_ZOOMABLE;
 				images[n].recode_flags |= old_zoom_flag;
 				zoom_factor = old_zoom_factor;
+				resume_rezoom_background( false );
 				return;
 			}
 		}
@@ -1985,6 +2543,9 @@ void register_image(struct bild_t* bild)
 		return;
 	}
 
+	// images may be reallocated
+	stop_rezoom_background();
+
 	if(  anz_images == alloc_images  ) {
 		if(  images==NULL  ) {
 			alloc_images = 510;
@@ -2040,6 +2601,8 @@ void register_image(struct bild_t* bild)
 	for(  uint8 i = 0;  i < MAX_PLAYER_COUNT;  i++  ) {
 		image->data[i] = NULL;
 	}
+	image->drawn_frame = 0;
+	image->in_player_data_images = false;
 
 	image->zoom_data = NULL;
 	image->len = bild->len;
@@ -2054,6 +2617,7 @@ void register_image(struct bild_t* bild)
 
 	// now find out, it contains player colors
 
+	resume_rezoom_background( false );
 }
 
 
@@ -2061,17 +2625,21 @@ void register_image(struct bild_t* bild)
 // (mostly needed when changing climate zones)
 void display_free_all_images_above( image_id above )
 {
+	stop_rezoom_background();
 	while(  above < anz_images  ) {
 		anz_images--;
 		if(  images[anz_images].zoom_data != NULL  ) {
-			guarded_free( images[anz_images].zoom_data );
+			image_data_free( images[anz_images].zoom_data );
 		}
-		for(  uint8 i = 0;  i < MAX_PLAYER_COUNT;  i++  ) {
-			if(  images[anz_images].data[i] != NULL  ) {
-				guarded_free( images[anz_images].data[i] );
-			}
+		if(  images[anz_images].data[0] != NULL  ) {
+			image_data_free( images[anz_images].data[0] );
+		}
+		free_player_data( anz_images );
+		if(  images[anz_images].in_player_data_images  ) {
+			player_data_images.remove( anz_images );
 		}
 	}
+	resume_rezoom_background( false );
 }
 
 
@@ -2427,6 +2995,7 @@ void display_img_aux(const image_id n, KOORD_VAL xp, KOORD_VAL yp, const sint8 p
 #endif
 {
 	if(  n < anz_images  ) {
+		images[n].drawn_frame = display_frame;
 		// only use player images if needed
 		const sint8 use_player = (images[n].recode_flags & FLAG_HAS_PLAYER_COLOR) * player_nr_raw;
 		// need to go to nightmode and or re-zoomed?
@@ -2505,6 +3074,9 @@ void display_img_aux(const image_id n, KOORD_VAL xp, KOORD_VAL yp, const sint8 p
 			// needed now ...
 			const KOORD_VAL w = images[n].w;
 			xp += images[n].x;
+			if(  !dirty  ) {
+				mark_rect_overdrawn( xp, yp, xp + w - 1, yp + h - 1 );
+			}
 
 			// clipping at poly lines?
 #ifdef MULTI_THREAD
@@ -2813,6 +3385,7 @@ void display_color_img(const image_id n, KOORD_VAL xp, KOORD_VAL yp, sint8 playe
 		else {
 		// do player colour substitution but not daynight - can't use cached images. Do NOT call multithreaded.
 		// prissi: now test if visible and clipping needed
+			images[n].drawn_frame = display_frame;
 			const KOORD_VAL x = images[n].x + xp;
 			      KOORD_VAL y = images[n].y + yp;
 			const KOORD_VAL w = images[n].w;
@@ -2830,6 +3403,9 @@ void display_color_img(const image_id n, KOORD_VAL xp, KOORD_VAL yp, sint8 playe
 			if(  dirty  ) {
 				mark_rect_dirty_wc( x, y, x + w - 1, y + h - 1 );
 			}
+			else {
+				mark_rect_overdrawn( x, y, x + w - 1, y + h - 1 );
+			}
 
 			activate_player_color( player_nr, daynight );
 
@@ -2914,6 +3490,9 @@ void display_base_img(const image_id n, KOORD_VAL xp, KOORD_VAL yp, const sint8
 		if (dirty) {
 			mark_rect_dirty_wc(x, y, x + w - 1, y + h - 1);
 		}
+		else {
+			mark_rect_overdrawn( x, y, x + w - 1, y + h - 1 );
+		}
 
 		// colors for 2nd company color
 		if(player_nr>=0) {
@@ -3169,7 +3748,114 @@ static void pix_outline25_16(PIXVAL *dest, const PIXVAL *, const PIXVAL colour,
 }
 
 
+#ifdef USE_PIXVEC
+/*
+ * The same calculations on several pixels at once; the results are exactly those of the routines above.
+ * The kernels are always inlined, so the wrappers below can compile them for different instruction sets.
+ */
+#define PIXVEC_INLINE inline __attribute__((always_inline))
+
+typedef PIXVAL pixvec8_t __attribute__((vector_size(16)));
+#ifdef USE_PIXVEC_AVX2
+typedef PIXVAL pixvec16_t __attribute__((vector_size(32)));
+#endif
+
+// vectors are passed by reference, since their calling convention depends on the instruction set
+template<class V> static PIXVEC_INLINE void pixvec_load(V &v, const PIXVAL *p)
+{
+	memcpy( &v, p, sizeof(V) );
+}
+
+
+template<class V> static PIXVEC_INLINE void pixvec_store(PIXVAL *p, const V &v)
+{
+	memcpy( p, &v, sizeof(V) );
+}
+
+
+/// source of a blend: the image, the image with player colours, or a single colour
+enum pixvec_source { PIXVEC_IMAGE, PIXVEC_RECODE, PIXVEC_COLOUR };
+
+template<class V, pixvec_source source> static PIXVEC_INLINE void pixvec_source_load(V &v, const PIXVAL *src, const PIXVAL colour)
+{
+	if(  source == PIXVEC_COLOUR  ) {
+		for(  unsigned i=0;  i<sizeof(V)/sizeof(PIXVAL);  i++  ) {
+			v[i] = colour;
+		}
+	}
+	else if(  source == PIXVEC_RECODE  ) {
+		PIXVAL buf[sizeof(V)/sizeof(PIXVAL)];
+		for(  unsigned i=0;  i<sizeof(V)/sizeof(PIXVAL);  i++  ) {
+			buf[i] = rgbmap_current[src[i]];
+		}
+		pixvec_load( v, buf );
+	}
+	else {
+		pixvec_load( v, src );
+	}
+}
+
+
+/// @param quarters amount of the source (1, 2 or 3) as pix_blend25/50/75
+template<class V, int quarters, PIXVAL one_out, PIXVAL two_out> static PIXVEC_INLINE void pixvec_blend(V &d, const V &s)
+{
+	if(  quarters == 2  ) {
+		d = ((s >> 1) & one_out) + ((d >> 1) & one_out);
+	}
+	else if(  quarters == 3  ) {
+		d = (PIXVAL)3*((s >> 2) & two_out) + ((d >> 2) & two_out);
+	}
+	else {
+		d = ((s >> 2) & two_out) + (PIXVAL)3*((d >> 2) & two_out);
+	}
+}
+
+
+template<class V, int quarters, pixvec_source source, bool rgb555> static PIXVEC_INLINE void pixvec_blend_run(PIXVAL *dest, const PIXVAL *src, const PIXVAL colour, const PIXVAL len)
+{
+	const PIXVAL one_out = rgb555 ? ONE_OUT_15 : ONE_OUT_16;
+	const PIXVAL two_out = rgb555 ? TWO_OUT_15 : TWO_OUT_16;
+	const unsigned n = sizeof(V)/sizeof(PIXVAL);
+	const PIXVAL *const end = dest + len;
+	while(  dest + n <= end  ) {
+		V s, d;
+		pixvec_source_load<V, source>( s, src, colour );
+		pixvec_load( d, dest );
+		pixvec_blend<V, quarters, one_out, two_out>( d, s );
+		pixvec_store( dest, d );
+		dest += n;
+		if(  source != PIXVEC_COLOUR  ) {
+			src += n;
+		}
+	}
+	// the rest pixel by pixel
+	while(  dest < end  ) {
+		const PIXVAL s = source == PIXVEC_COLOUR ? colour : (source == PIXVEC_RECODE ? rgbmap_current[*src++] : *src++);
+		*dest = quarters == 2 ? ((s>>1) & one_out) + (((*dest)>>1) & one_out)
+		      : quarters == 3 ? 3*((s>>2) & two_out) + (((*dest)>>2) & two_out)
+		      :                 ((s>>2) & two_out) + 3*(((*dest)>>2) & two_out);
+		dest++;
+	}
+}
+
+
+template<int quarters, pixvec_source source, bool rgb555> static void pix_blend_vec(PIXVAL *dest, const PIXVAL *src, const PIXVAL colour, const PIXVAL len)
+{
+	pixvec_blend_run<pixvec8_t, quarters, source, rgb555>( dest, src, colour, len );
+}
+
+
+#ifdef USE_PIXVEC_AVX2
+template<int quarters, pixvec_source source, bool rgb555> __attribute__((target("avx2"))) static void pix_blend_avx2(PIXVAL *dest, const PIXVAL *src, const PIXVAL colour, const PIXVAL len)
+{
+	pixvec_blend_run<pixvec16_t, quarters, source, rgb555>( dest, src, colour, len );
+}
+#endif
+#endif
+
+
 // will kept the actual values
+static bool pixel_rgb555 = false;
 static blend_proc blend[3];
 static blend_proc blend_recode[3];
 static blend_proc outline[3];
@@ -3187,6 +3873,7 @@ void display_blend_wh_rgb(KOORD_VAL xp, KOORD_VAL yp, KOORD_VAL w, KOORD_VAL h,
 	if(  clip_lr( &xp, &w, clip_rect.x, clip_rect.xx )  &&  clip_lr( &yp, &h, clip_rect.y, clip_rect.yy )  ) {
 #endif
 		const PIXVAL alpha = (percent_blend*64)/100;
+		mark_rect_overdrawn( xp, yp, xp + w - 1, yp + h - 1 );
 
 		switch( alpha ) {
 			case 0:	// nothing to do ...
@@ -3212,7 +3899,7 @@ void display_blend_wh_rgb(KOORD_VAL xp, KOORD_VAL yp, KOORD_VAL w, KOORD_VAL h,
 
 			default:
 				// any percentage blending: SLOW!
-				if(  blend[0] == pix_blend25_15  ) {
+				if(  pixel_rgb555  ) {
 					// 555 BITMAPS
 					const PIXVAL r_src = (colval >> 10) & 0x1F;
 					const PIXVAL g_src = (colval >> 5) & 0x1F;
@@ -3469,6 +4156,66 @@ static void pix_alpha_recode_16(PIXVAL *dest, const PIXVAL *src, const PIXVAL *a
 }
 
 
+#ifdef USE_PIXVEC
+/*
+ * Same as pix_alpha_xx, but the components are blended separately, so each fits into 16 bits.
+ * The pixels which are not a multiple of the vector length are done by the scalar routine.
+ */
+template<class V, pixvec_source source, bool rgb555, alpha_proc scalar> static PIXVEC_INLINE void pixvec_alpha_run(PIXVAL *dest, const PIXVAL *src, const PIXVAL *alphamap, const unsigned alpha_flags, const PIXVAL colour, const PIXVAL len)
+{
+	const unsigned n = sizeof(V)/sizeof(PIXVAL);
+	const PIXVAL red_shift = rgb555 ? 10 : 11;
+	const PIXVAL green_mask = rgb555 ? 0x03e0 : 0x07e0;
+
+	const PIXVAL rmask = alpha_flags & ALPHA_RED ? 0x001f : 0;
+	const PIXVAL gmask = alpha_flags & ALPHA_GREEN ? 0x03e0 : 0;
+	const PIXVAL bmask = alpha_flags & ALPHA_BLUE ? 0x7c00 : 0;
+
+	const PIXVAL *const end = dest + len;
+	while(  dest + n <= end  ) {
+		// read mask components - always 15bpp
+		V am, s, d;
+		pixvec_load( am, alphamap );
+		pixvec_source_load<V, source>( s, src, colour );
+		pixvec_load( d, dest );
+		const V alpha_value = (am & rmask) + ((am & gmask) >> 5) + ((am & bmask) >> 10);
+		// comparisons give -1 for true
+		const V opaque = (V)(alpha_value > 30);
+		const V clear = (V)(alpha_value == 0);
+		const V a = alpha_value - (V)(alpha_value > 15);
+		const V na = (PIXVAL)32 - a;
+
+		const V r = ((((s >> red_shift) & 31) * a + ((d >> red_shift) & 31) * na) >> 5) << red_shift;
+		const V g = (((s & green_mask) * a + (d & green_mask) * na) >> 5) & green_mask;
+		const V b = ((s & 31) * a + (d & 31) * na) >> 5;
+
+		d = (s & opaque) | (d & clear) | ((r | g | b) & ~(opaque | clear));
+		pixvec_store( dest, d );
+		dest += n;
+		src += n;
+		alphamap += n;
+	}
+	if(  dest < end  ) {
+		scalar( dest, src, alphamap, alpha_flags, colour, end - dest );
+	}
+}
+
+
+template<pixvec_source source, bool rgb555, alpha_proc scalar> static void pix_alpha_vec(PIXVAL *dest, const PIXVAL *src, const PIXVAL *alphamap, const unsigned alpha_flags, const PIXVAL colour, const PIXVAL len)
+{
+	pixvec_alpha_run<pixvec8_t, source, rgb555, scalar>( dest, src, alphamap, alpha_flags, colour, len );
+}
+
+
+#ifdef USE_PIXVEC_AVX2
+template<pixvec_source source, bool rgb555, alpha_proc scalar> __attribute__((target("avx2"))) static void pix_alpha_avx2(PIXVAL *dest, const PIXVAL *src, const PIXVAL *alphamap, const unsigned alpha_flags, const PIXVAL colour, const PIXVAL len)
+{
+	pixvec_alpha_run<pixvec16_t, source, rgb555, scalar>( dest, src, alphamap, alpha_flags, colour, len );
+}
+#endif
+#endif
+
+
 #ifdef MULTI_THREAD
 static void display_img_alpha_wc(KOORD_VAL h, const KOORD_VAL xp, const KOORD_VAL yp, const PIXVAL *sp, const PIXVAL *alphamap, const uint8 alpha_flags, int colour, alpha_proc p, const sint8 clip_num )
 #else
@@ -3529,6 +4276,7 @@ void display_rezoomed_img_blend(const image_id n, KOORD_VAL xp, KOORD_VAL yp, co
 #endif
 {
 	if(  n < anz_images  ) {
+		images[n].drawn_frame = display_frame;
 		// need to go to nightmode and or rezoomed?
 		if(  (images[n].recode_flags & FLAG_REZOOM)  ) {
 			rezoom_img( n );
@@ -3593,6 +4341,9 @@ void display_rezoomed_img_blend(const image_id n, KOORD_VAL xp, KOORD_VAL yp, co
 			const PIXVAL color = specialcolormap_all_day[color_index & 0xFF];
 			// we use function pointer for the blend runs for the moment ...
 			blend_proc pix_blend = (color_index&OUTLINE_FLAG) ? outline[ (color_index&TRANSPARENT_FLAGS)/TRANSPARENT25_FLAG - 1 ] : blend[ (color_index&TRANSPARENT_FLAGS)/TRANSPARENT25_FLAG - 1 ];
+			if(  !dirty  ) {
+				mark_rect_overdrawn( xp, yp, xp + w - 1, yp + h - 1 );
+			}
 
 			// use horizontal clipping or skip it?
 #ifdef MULTI_THREAD
@@ -3632,6 +4383,8 @@ void display_rezoomed_img_alpha(const image_id n, const image_id alpha_n, const
 #endif
 {
 	if(  n < anz_images  &&  alpha_n < anz_images  ) {
+		images[n].drawn_frame = display_frame;
+		images[alpha_n].drawn_frame = display_frame;
 		// need to go to nightmode and or rezoomed?
 		if(  (images[n].recode_flags & FLAG_REZOOM)  ) {
 			rezoom_img( n );
@@ -3703,6 +4456,9 @@ void display_rezoomed_img_alpha(const image_id n, const image_id alpha_n, const
 			const KOORD_VAL w = images[n].w;
 			// get the real color
 			const PIXVAL color = specialcolormap_all_day[color_index & 0xFF];
+			if(  !dirty  ) {
+				mark_rect_overdrawn( xp, yp, xp + w - 1, yp + h - 1 );
+			}
 
 			// use horizontal clipping or skip it?
 #ifdef MULTI_THREAD
@@ -3817,6 +4573,9 @@ void display_base_img_blend(const image_id n, KOORD_VAL xp, KOORD_VAL yp, const
 					activate_player_color( 0, daynight );
 				}
 			}
+			if(  !dirty  ) {
+				mark_rect_overdrawn( x, y, x + w - 1, y + h - 1 );
+			}
 
 			// use horizontal clipping or skip it?
 #ifdef MULTI_THREAD
@@ -3933,6 +4692,9 @@ void display_base_img_alpha(const image_id n, const image_id alpha_n, const unsi
 					activate_player_color( 0, daynight );
 				}
 			}
+			if(  !dirty  ) {
+				mark_rect_overdrawn( x, y, x + w - 1, y + h - 1 );
+			}
 
 			// use horizontal clipping or skip it?
 #ifdef MULTI_THREAD
@@ -4031,6 +4793,9 @@ static void display_fb_internal(KOORD_VAL xp, KOORD_VAL yp, KOORD_VAL w, KOORD_V
 		if (dirty) {
 			mark_rect_dirty_nc(xp, yp, xp + w - 1, yp + h - 1);
 		}
+		else {
+			mark_rect_overdrawn( xp, yp, xp + w - 1, yp + h - 1 );
+		}
 
 		do {
 #ifdef USE_C
@@ -4105,6 +4870,7 @@ static void display_vl_internal(const KOORD_VAL xp, KOORD_VAL yp, KOORD_VAL h, c
 		PIXVAL *p = textur + xp + yp * disp_width;
 
 		if (dirty) mark_rect_dirty_nc(xp, yp, xp, yp + h - 1);
+		else mark_rect_overdrawn(xp, yp, xp, yp + h - 1);
 
 		do {
 			*p = colval;
@@ -4644,6 +5410,9 @@ int display_text_proportional_len_clip_rgb(KOORD_VAL x, KOORD_VAL y, const char*
 		mark_rect_dirty_clip( x0, y, x - 1, y + 10 - 1 );
 #endif
 	}
+	else {
+		mark_rect_overdrawn( x0, y, x - 1, y + 10 - 1 );
+	}
 	// warning: actual len might be longer, due to clipping!
 	return x - x0;
 }
@@ -5092,6 +5861,7 @@ void display_flush_buffer()
 	{
 		0, 1, 28, 2, 29, 14, 24, 3, 30, 22, 20, 15, 25, 17, 4, 8, 31, 27, 13, 23, 21, 19, 16, 7, 26, 12, 18, 6, 11, 5, 10, 9
 	};
+	update_image_caches();
 #ifdef USE_SOFTPOINTER
 	ex_ord_update_mx_my();
 
@@ -5337,9 +6107,11 @@ void simgraph_init(KOORD_VAL width, KOORD_VAL height, int full_screen)
 
 	tile_dirty = MALLOCN( uint32, tile_buffer_length );
 	tile_dirty_old = MALLOCN( uint32, tile_buffer_length );
+	tile_overdrawn = MALLOCN( uint32, tile_buffer_length );
 
 	mark_screen_dirty();
 	MEMZERON( tile_dirty_old, tile_buffer_length );
+	MEMZERON( tile_overdrawn, tile_buffer_length );
 
 	// init player colors
 	for( int i = 0;  i < MAX_PLAYER_COUNT;  i++  ) {
@@ -5360,6 +6132,7 @@ void simgraph_init(KOORD_VAL width, KOORD_VAL height, int full_screen)
 		while((c&1)==0) {
 			c >>= 1;
 		}
+		pixel_rgb555 = c==31;
 		if(c==31) {
 			// 15 bit per pixel
 			blend[0] = pix_blend25_15;
@@ -5387,6 +6160,44 @@ void simgraph_init(KOORD_VAL width, KOORD_VAL height, int full_screen)
 			alpha = pix_alpha_16;
 			alpha_recode = pix_alpha_recode_16;
 		}
+#ifdef USE_PIXVEC
+		// same results, several pixels at once
+#define SET_PIXVEC_PROCS(blend_tpl, alpha_tpl, rgb555, bpp) \
+			blend[0] = blend_tpl<1, PIXVEC_IMAGE, rgb555>; \
+			blend[1] = blend_tpl<2, PIXVEC_IMAGE, rgb555>; \
+			blend[2] = blend_tpl<3, PIXVEC_IMAGE, rgb555>; \
+			blend_recode[0] = blend_tpl<1, PIXVEC_RECODE, rgb555>; \
+			blend_recode[1] = blend_tpl<2, PIXVEC_RECODE, rgb555>; \
+			blend_recode[2] = blend_tpl<3, PIXVEC_RECODE, rgb555>; \
+			outline[0] = blend_tpl<1, PIXVEC_COLOUR, rgb555>; \
+			outline[1] = blend_tpl<2, PIXVEC_COLOUR, rgb555>; \
+			outline[2] = blend_tpl<3, PIXVEC_COLOUR, rgb555>; \
+			alpha = alpha_tpl<PIXVEC_IMAGE, rgb555, pix_alpha_##bpp>; \
+			alpha_recode = alpha_tpl<PIXVEC_RECODE, rgb555, pix_alpha_recode_##bpp>;
+
+		const char *simd = "sse2/neon";
+#ifdef USE_PIXVEC_AVX2
+		__builtin_cpu_init();
+		if(  __builtin_cpu_supports("avx2")  ) {
+			simd = "avx2";
+			if(  pixel_rgb555  ) {
+				SET_PIXVEC_PROCS( pix_blend_avx2, pix_alpha_avx2, true, 15 )
+			}
+			else {
+				SET_PIXVEC_PROCS( pix_blend_avx2, pix_alpha_avx2, false, 16 )
+			}
+		}
+		else
+#endif
+		if(  pixel_rgb555  ) {
+			SET_PIXVEC_PROCS( pix_blend_vec, pix_alpha_vec, true, 15 )
+		}
+		else {
+			SET_PIXVEC_PROCS( pix_blend_vec, pix_alpha_vec, false, 16 )
+		}
+#undef SET_PIXVEC_PROCS
+		dbg->message( "simgraph_init()", "using %s for blending", simd );
+#endif
 	}
 
 	printf("Init done.\n");
@@ -5412,12 +6223,26 @@ void simgraph_exit()
 {
 	dr_os_close();
 
+#ifdef MULTI_THREAD
+	if(  rezoom_background_started  ) {
+		pthread_mutex_lock( &rezoom_background_mutex );
+		rezoom_background_quit = true;
+		pthread_cond_broadcast( &rezoom_background_work_cond );
+		pthread_mutex_unlock( &rezoom_background_mutex );
+		pthread_join( rezoom_background_thread, NULL );
+		rezoom_background_started = false;
+	}
+#endif
+
 	guarded_free( tile_dirty_old );
 	guarded_free( tile_dirty );
+	guarded_free( tile_overdrawn );
+	guarded_free( world_textur );
+	world_textur = NULL;
 	display_free_all_images_above(0);
 	guarded_free(images);
 
-	tile_dirty = tile_dirty_old = NULL;
+	tile_dirty = tile_dirty_old = tile_overdrawn = NULL;
 	images = NULL;
 #ifdef MULTI_THREAD
 	pthread_mutex_destroy( &recode_img_mutex );
@@ -5446,6 +6271,7 @@ void simgraph_resize(KOORD_VAL w, KOORD_VAL h)
 
 			guarded_free( tile_dirty_old );
 			guarded_free( tile_dirty);
+			guarded_free( tile_overdrawn );
 
 			// allocate dirty tile flags
 			tiles_per_line = (disp_width + DIRTY_TILE_SIZE - 1) / DIRTY_TILE_SIZE;
@@ -5455,12 +6281,14 @@ void simgraph_resize(KOORD_VAL w, KOORD_VAL h)
 
 			tile_dirty = MALLOCN( uint32, tile_buffer_length );
 			tile_dirty_old = MALLOCN( uint32, tile_buffer_length );
+			tile_overdrawn = MALLOCN( uint32, tile_buffer_length );
 
 			display_set_clip_wh(0, 0, disp_actual_width, disp_height);
 		}
 
 		mark_screen_dirty();
 		MEMZERON( tile_dirty_old, tile_buffer_length );
+		MEMZERON( tile_overdrawn, tile_buffer_length );
 	}
 }
 
@@ -23,11 +23,13 @@
 #include "../dataobj/environment.h"
 #include "../obj/zeiger.h"
 #include "../utils/simrandom.h"
+#include "../tpl/vector_tpl.h"
 
 karte_ansicht_t::karte_ansicht_t(karte_t *welt)
 {
 	this->welt = welt;
 	outside_visible = true;
+	last_cursor_pos = koord::invalid;
 	viewport = welt->get_viewport();
 	assert(welt  &&  viewport);
 }
@@ -42,9 +44,22 @@ static const sint8 hours2night[] =
     2,3,4,4,4,4,4,4
 };
 
+// parts of the screen where the world is drawn again in this frame
+#define MAX_REDRAW_RECTS (16)
+static scr_rect redraw_rects[MAX_REDRAW_RECTS];
+static int redraw_rect_count = 0;
+
+// tiles with changed grounds or objects since the last frame, see karte_ansicht_t::mark_tile_changed()
+// (without a display, e.g. on a server, the list stops growing at the limit)
+#define MAX_CHANGED_TILES (65536)
+static vector_tpl<koord> changed_tiles;
+static bool changed_tiles_overflow = false;
+
 #ifdef MULTI_THREAD
 #include "../utils/simthread.h"
 
+static pthread_mutex_t changed_tiles_mutex = PTHREAD_MUTEX_INITIALIZER;
+
 bool spawned_threads=false; // global job indicator array
 static simthread_barrier_t display_barrier_start;
 static simthread_barrier_t display_barrier_end;
@@ -53,7 +68,6 @@ static simthread_barrier_t display_barrier_end;
 typedef struct{
 	karte_ansicht_t *show_routine;
 	koord   lt_cl, wh_cl; // pos/size of clipping rect for this thread
-	koord   lt, wh;       // pos/size of region to display. set larger than clipping for correct display of trees at thread seams
 	sint16  y_min;
 	sint16  y_max;
 	sint8   thread_num;
@@ -68,8 +82,7 @@ void *display_region_thread( void *ptr )
 	while(true) {
 		simthread_barrier_wait( &display_barrier_start ); // wait for all to start
 		clear_all_poly_clip( view->thread_num );
-		display_set_clip_wh_cl( view->lt_cl.x, view->lt_cl.y, view->wh_cl.x, view->wh_cl.y, view->thread_num );
-		view->show_routine->display_region( view->lt, view->wh, view->y_min, view->y_max, false, true, view->thread_num );
+		view->show_routine->display_rects( view->lt_cl, view->wh_cl, view->y_min, view->y_max, true, view->thread_num );
 		simthread_barrier_wait( &display_barrier_end ); // wait for all to finish
 	}
 	return ptr;
@@ -145,25 +158,34 @@ void karte_ansicht_t::display(bool force_dirty)
 		display_day_night_shift(hours2night[stunden2]+env_t::daynight_level);
 	}
 
+	// to save calls to grund_t::get_disp_height
+	// gr->get_disp_height() == min(gr->get_hoehe(), hmax_ground)
+	const sint8 hmax_ground = (grund_t::underground_mode==grund_t::ugm_level) ? grund_t::underground_level : 127;
+
+	// lower limit for y: display correctly water/outside graphics at upper border of screen
+	int y_min = (-const_y_off + 4*tile_raster_scale_y( min(hmax_ground, welt->get_grundwasser())*TILE_HEIGHT_STEP, IMG_SIZE )
+					+ 4*(menu_height-IMG_SIZE)-IMG_SIZE/2-1) / IMG_SIZE;
+
+	// the world keeps its last image, it is only drawn again where something has changed
+	mark_changed_tiles();
+	// we check if background will be visible, no need to clear screen if it's not.
+	const bool draw_background = !grund_t::underground_mode  &&  welt->is_background_dirty()  &&  outside_visible;
+	// the animated water is not marked before
+	redraw_rect_count = display_world_begin( redraw_rects, MAX_REDRAW_RECTS, menu_height, disp_height - menu_height, draw_background  ||  wasser_t::change_stage );
+
 	// not very elegant, but works:
 	// fill everything with black for Underground mode ...
 	if( grund_t::underground_mode ) {
-		display_fillbox_wh(0, menu_height, disp_width, disp_height-menu_height, COL_BLACK, force_dirty);
+		for(  int r = 0;  r < redraw_rect_count;  r++  ) {
+			display_fillbox_wh( redraw_rects[r].x, redraw_rects[r].y, redraw_rects[r].w, redraw_rects[r].h, COL_BLACK, force_dirty );
+		}
 	}
-	else if( welt->is_background_dirty()  &&  outside_visible  ) {
-		// we check if background will be visible, no need to clear screen if it's not.
+	else if(  draw_background  ) {
 		display_background(0, menu_height, disp_width, disp_height-menu_height, force_dirty);
 		welt->unset_background_dirty();
 		// reset
 		outside_visible = false;
 	}
-	// to save calls to grund_t::get_disp_height
-	// gr->get_disp_height() == min(gr->get_hoehe(), hmax_ground)
-	const sint8 hmax_ground = (grund_t::underground_mode==grund_t::ugm_level) ? grund_t::underground_level : 127;
-
-	// lower limit for y: display correctly water/outside graphics at upper border of screen
-	int y_min = (-const_y_off + 4*tile_raster_scale_y( min(hmax_ground, welt->get_grundwasser())*TILE_HEIGHT_STEP, IMG_SIZE )
-					+ 4*(menu_height-IMG_SIZE)-IMG_SIZE/2-1) / IMG_SIZE;
 
 #ifdef MULTI_THREAD
 	if(  can_multithreading  ) {
@@ -182,6 +204,7 @@ void karte_ansicht_t::display(bool force_dirty)
 				if(  pthread_create( &thread[t], &attr, display_region_thread, (void *)&ka[t] )  ) {
 					can_multithreading = false;
 					dbg->error( "karte_ansicht_t::display()", "cannot multi-thread, error at thread #%i", t+1 );
+					display_world_end();
 					return;
 				}
 			}
@@ -196,8 +219,6 @@ void karte_ansicht_t::display(bool force_dirty)
 		   	ka[t].show_routine = this;
 			ka[t].lt_cl = koord( lt_x, menu_height );
 			ka[t].wh_cl = koord( wh_x, disp_height - menu_height );
-			ka[t].lt = ka[t].lt_cl - koord( IMG_SIZE/2, 0 ); // process tiles IMG_SIZE/2 outside clipping range for correct tree display at thread seams
-			ka[t].wh = ka[t].wh_cl + koord( IMG_SIZE, 0 );
 			ka[t].y_min = y_min;
 			ka[t].y_max = dpy_height + 4 * 4;
 			ka[t].thread_num = t;
@@ -213,23 +234,25 @@ void karte_ansicht_t::display(bool force_dirty)
 
 		// the last we can run ourselves, setting clip_wh to the screen edge instead of wh_x (in case disp_width % num_threads != 0)
 		clear_all_poly_clip( env_t::num_threads - 1 );
-		display_set_clip_wh_cl( lt_x, menu_height, disp_width - lt_x, disp_height - menu_height, env_t::num_threads - 1 );
-		display_region( koord( lt_x - IMG_SIZE / 2, menu_height ), koord( disp_width - lt_x + IMG_SIZE, disp_height - menu_height ), y_min, dpy_height + 4 * 4, false, true, env_t::num_threads - 1 );
+		display_rects( koord( lt_x, menu_height ), koord( disp_width - lt_x, disp_height - menu_height ), y_min, dpy_height + 4 * 4, true, env_t::num_threads - 1 );
 
 		simthread_barrier_wait( &display_barrier_end );
 
 		clear_all_poly_clip( 0 );
-		display_set_clip_wh( 0, menu_height, disp_width, disp_height-menu_height );
 	}
 	else {
 		// slow serial way of display
 		clear_all_poly_clip( 0 );
-		display_region( koord( 0, menu_height ), koord( disp_width, disp_height - menu_height ), y_min, dpy_height + 4 * 4, false, false, 0 );
+		display_rects( koord( 0, menu_height ), koord( disp_width, disp_height - menu_height ), y_min, dpy_height + 4 * 4, false, 0 );
 	}
 #else
 	clear_all_poly_clip();
-	display_region( koord( 0, menu_height ), koord( disp_width, disp_height - menu_height ), y_min, dpy_height + 4 * 4, false );
+	display_rects( koord( 0, menu_height ), koord( disp_width, disp_height - menu_height ), y_min, dpy_height + 4 * 4 );
 #endif
+	display_set_clip_wh( 0, menu_height, disp_width, disp_height-menu_height );
+
+	// everything else is drawn on top of the world each frame
+	display_world_end();
 
 	// and finally overlays (station coverage and signs)
 	bool plotted = false; // display overlays even on very large mountains
@@ -245,8 +268,8 @@ void karte_ansicht_t::display(bool force_dirty)
 			if(  xpos+IMG_SIZE>0  ) {
 				const planquadrat_t *plan=welt->access(i,j);
 				if(plan  &&  plan->get_kartenboden()) {
-					const grund_t *gr = plan->get_kartenboden();
-					sint16 yypos = ypos - tile_raster_scale_y( min(gr->get_hoehe(),hmax_ground)*TILE_HEIGHT_STEP, IMG_SIZE);
+					// the height is kept in the tile, so invisible tiles are skipped without touching their ground
+					sint16 yypos = ypos - tile_raster_scale_y( min(plan->get_kartenboden_hoehe(),hmax_ground)*TILE_HEIGHT_STEP, IMG_SIZE);
 					if(  yypos-IMG_SIZE<disp_real_height  &&  yypos+IMG_SIZE>=menu_height  ) {
 						plan->display_overlay( xpos, yypos );
 						plotted = true;
@@ -537,6 +560,38 @@ void karte_ansicht_t::display_region( koord lt, koord wh, sint16 y_min, sint16 y
 			}
 		}
 	}
+}
+
+
+#ifdef MULTI_THREAD
+void karte_ansicht_t::display_rects( koord lt_cl, koord wh_cl, sint16 y_min, sint16 y_max, bool threaded, const sint8 clip_num )
+#else
+void karte_ansicht_t::display_rects( koord lt_cl, koord wh_cl, sint16 y_min, sint16 y_max )
+#endif
+{
+	const sint16 IMG_SIZE = get_tile_raster_width();
+
+	for(  int r = 0;  r < redraw_rect_count;  r++  ) {
+		const scr_rect &rect = redraw_rects[r];
+		const KOORD_VAL x1 = max( rect.x, lt_cl.x );
+		const KOORD_VAL y1 = max( rect.y, lt_cl.y );
+		const KOORD_VAL x2 = min( rect.get_right(), lt_cl.x + wh_cl.x );
+		const KOORD_VAL y2 = min( rect.get_bottom(), lt_cl.y + wh_cl.y );
+		if(  x1 >= x2  ||  y1 >= y2  ) {
+			continue;
+		}
+		// process tiles IMG_SIZE/2 outside clipping range for correct display of trees and vehicles at the seams
+		// and the tiles below as far as the highest objects and bridges can reach up into the rectangle
+		const koord lt( x1 - IMG_SIZE / 2, y1 - IMG_SIZE / 2 );
+		const koord wh( x2 - x1 + IMG_SIZE, y2 - y1 + IMG_SIZE / 2 + IMG_SIZE * 3 );
+#ifdef MULTI_THREAD
+		display_set_clip_wh_cl( x1, y1, x2 - x1, y2 - y1, clip_num );
+		display_region( lt, wh, y_min, y_max, false, threaded, clip_num );
+#else
+		display_set_clip_wh( x1, y1, x2 - x1, y2 - y1 );
+		display_region( lt, wh, y_min, y_max, false );
+#endif
+	}
 #ifdef MULTI_THREAD
 	// show thread as paused when finished
 	if(  threaded  ) {
@@ -549,6 +604,114 @@ void karte_ansicht_t::display_region( koord lt, koord wh, sint16 y_min, sint16 y
 }
 
 
+void karte_ansicht_t::mark_tile_changed(koord pos)
+{
+#ifdef MULTI_THREAD
+	pthread_mutex_lock( &changed_tiles_mutex );
+#endif
+	if(  changed_tiles.get_count() < MAX_CHANGED_TILES  ) {
+		changed_tiles.append( pos );
+	}
+	else {
+		changed_tiles_overflow = true;
+	}
+#ifdef MULTI_THREAD
+	pthread_mutex_unlock( &changed_tiles_mutex );
+#endif
+}
+
+
+void karte_ansicht_t::mark_changed_tiles()
+{
+	const sint16 IMG_SIZE = get_tile_raster_width();
+	const sint16 disp_height = display_get_height();
+
+	const int i_off = viewport->get_world_position().x + viewport->get_viewport_ij_offset().x;
+	const int j_off = viewport->get_world_position().y + viewport->get_viewport_ij_offset().y;
+	const int const_x_off = viewport->get_x_off();
+	const int const_y_off = viewport->get_y_off();
+
+	const sint8 hmax_ground = (grund_t::underground_mode == grund_t::ugm_level) ? grund_t::underground_level : 127;
+
+	// trees and buildings appear or vanish around the old and the new cursor position
+	const koord cursor_pos = welt->get_zeiger() ? welt->get_zeiger()->get_pos().get_2d() : koord(-1000, -1000);
+	if(  env_t::hide_under_cursor  &&  cursor_pos != last_cursor_pos  ) {
+		const koord centers[2] = { cursor_pos, last_cursor_pos };
+		const sint16 range = env_t::cursor_hide_range;
+		for(  int c = 0;  c < 2;  c++  ) {
+			for(  sint16 dj = -range;  dj <= range;  dj++  ) {
+				for(  sint16 di = -range;  di <= range;  di++  ) {
+					const koord pos = centers[c] + koord( di, dj );
+					const planquadrat_t *plan = welt->access( pos );
+					if(  plan  &&  plan->get_kartenboden()  &&  koord_distance( pos, centers[c] ) < env_t::cursor_hide_range  ) {
+						const int x = (pos.x - i_off) - (pos.y - j_off);
+						const int y = (pos.x - i_off) + (pos.y - j_off);
+						const sint16 xpos = x * (IMG_SIZE / 2) + const_x_off;
+						const sint16 yypos = y * (IMG_SIZE / 4) + const_y_off - tile_raster_scale_y( min( plan->get_kartenboden_hoehe(), hmax_ground ) * TILE_HEIGHT_STEP, IMG_SIZE );
+						mark_rect_dirty_wc( xpos, yypos - IMG_SIZE * 3, xpos + IMG_SIZE - 1, yypos + IMG_SIZE - 1 );
+					}
+				}
+			}
+		}
+	}
+	last_cursor_pos = cursor_pos;
+
+	// take the list, the next one is collected meanwhile
+	static vector_tpl<koord> tiles;
+	tiles.clear();
+#ifdef MULTI_THREAD
+	pthread_mutex_lock( &changed_tiles_mutex );
+#endif
+	swap( tiles, changed_tiles );
+	const bool overflow = changed_tiles_overflow;
+	changed_tiles_overflow = false;
+#ifdef MULTI_THREAD
+	pthread_mutex_unlock( &changed_tiles_mutex );
+#endif
+	if(  overflow  ) {
+		mark_screen_dirty();
+		return;
+	}
+
+	FOR( vector_tpl<koord>, const pos, tiles ) {
+		const planquadrat_t *plan = welt->access( pos );
+		if(  !plan  ||  !plan->get_kartenboden()  ) {
+			continue;
+		}
+		// same screen position as in display_region()
+		const int x = (pos.x - i_off) - (pos.y - j_off);
+		const int y = (pos.x - i_off) + (pos.y - j_off);
+		const sint16 xpos = x * (IMG_SIZE / 2) + const_x_off;
+		const sint16 ypos = y * (IMG_SIZE / 4) + const_y_off;
+		const sint16 yypos = ypos - tile_raster_scale_y( min( plan->get_kartenboden_hoehe(), hmax_ground ) * TILE_HEIGHT_STEP, IMG_SIZE );
+		if(  xpos + IMG_SIZE <= 0  ||  xpos >= display_get_width()  ||  yypos - IMG_SIZE * 3 >= disp_height  ||  yypos + IMG_SIZE <= 0  ) {
+			continue;
+		}
+
+		for(  uint b = 0;  b < plan->get_boden_count();  b++  ) {
+			const grund_t *gr = plan->get_boden_bei( b );
+			if(  gr->get_flag( grund_t::dirty )  ) {
+				// including walls and fences
+				const sint16 gr_ypos = ypos - tile_raster_scale_y( gr->get_disp_height() * TILE_HEIGHT_STEP, IMG_SIZE );
+				mark_rect_dirty_wc( xpos, gr_ypos - IMG_SIZE, xpos + IMG_SIZE - 1, gr_ypos + IMG_SIZE - 1 );
+			}
+			for(  uint8 n = 0;  n < gr->get_top();  n++  ) {
+				const obj_t *obj = gr->obj_bei( n );
+				if(  obj->get_flag( obj_t::dirty )  ) {
+					// all the images obj_t::display() will draw
+					obj->mark_image_dirty( obj->get_image(), 0 );
+					for(  int h = 1;  obj->get_image( h ) != IMG_LEER;  h++  ) {
+						obj->mark_image_dirty( obj->get_image( h ), -h * IMG_SIZE );
+					}
+					obj->mark_image_dirty( obj->get_front_image(), 0 );
+					obj->mark_image_dirty( obj->get_outline_image(), 0 );
+				}
+			}
+		}
+	}
+}
+
+
 void karte_ansicht_t::display_background( KOORD_VAL xp, KOORD_VAL yp, KOORD_VAL w, KOORD_VAL h, bool dirty )
 {
 	if(  !(env_t::draw_earth_border  &&  env_t::draw_outside_tile)  ) {
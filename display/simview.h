@@ -7,6 +7,9 @@
 #ifndef simview_h
 #define simview_h
 
+#include "../dataobj/koord.h"
+#include "simgraph.h"
+
 class karte_t;
 class viewport_t;
 
@@ -26,9 +29,24 @@ private:
 	/// Cached value from last display run to determine if the background was visible, we'll save redraws if it was not.
 	bool outside_visible;
 
+	/// Cursor position of the last display run, trees and buildings were hidden around it.
+	koord last_cursor_pos;
+
+	/**
+	 * Marks the screen areas of the grounds and objects with the dirty flag on the tiles reported by mark_tile_changed(),
+	 * so the world is drawn again there.
+	 */
+	void mark_changed_tiles();
+
 public:
 	karte_ansicht_t(karte_t *welt);
 
+	/**
+	 * A ground or object on this tile got the dirty flag, called by their set_flag().
+	 * Thread safe, since vehicles move in parallel.
+	 */
+	static void mark_tile_changed(koord pos);
+
 	/**
 	 * Draws the visible world on screen.
 	 * @param dirty If set to true, will mark the whole screen as dirty.
@@ -56,6 +74,18 @@ public:
 	void display_region( koord lt, koord wh, sint16 y_min, const sint16 y_max, bool force_dirty );
 #endif
 
+	/**
+	 * Draws the world in all areas found by display_world_begin() which overlap with the clipping rectangle.
+	 * @param lt_cl Top-left pixel coordinate of the clipping rectangle.
+	 * @param wh_cl Width and height of the clipping rectangle.
+	 * @see display_region() for the other parameters.
+	 */
+#ifdef MULTI_THREAD
+	void display_rects( koord lt_cl, koord wh_cl, sint16 y_min, const sint16 y_max, bool threaded, const sint8 clip_num );
+#else
+	void display_rects( koord lt_cl, koord wh_cl, sint16 y_min, const sint16 y_max );
+#endif
+
 	/**
 	 * Draws background in the specified rectangular screen coordinates.
 	 * @param xp X screen coordinate of the left-top corner.
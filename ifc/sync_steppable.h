@@ -19,6 +19,14 @@ public:
      */
     virtual bool sync_step(uint32 delta_t) = 0;
 
+    /**
+     * The part of sync_step(), which may run in parallel to the other objects.
+     * It must only change this object and must not call simrand().
+     * Whether the step is done here, must only depend on the state of this object.
+     * @return true, when the complete sync_step() was done; false, when sync_step() must do it later
+     */
+    virtual bool sync_step_local(uint32 /*delta_t*/) { return false; }
+
     virtual ~sync_steppable() {}
 };
 
@@ -126,6 +126,20 @@ void checksum_t::input(sint32 data)
 }
 
 
+void checksum_t::input(uint64 data)
+{
+	uint64 little_endian = endian(data);
+	assert(sha);
+	sha->Input((const char*)&little_endian, sizeof(uint64));
+}
+
+
+void checksum_t::input(sint64 data)
+{
+	input((uint64)data);
+}
+
+
 void checksum_t::input(const char *data)
 {
 	if (data==NULL) {
@@ -146,6 +160,15 @@ const char* checksum_t::get_str(const int maxlen) const
 }
 
 
+uint32 checksum_t::get_short_digest()
+{
+	if (!valid) {
+		finish();
+	}
+	return message_digest[0] | (message_digest[1] << 8) | (message_digest[2] << 16) | ((uint32)message_digest[3] << 24);
+}
+
+
 void checksum_t::calc_checksum(checksum_t *chk) const
 {
 	for(uint8 i=0; i<20; i++) {
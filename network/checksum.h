@@ -31,9 +31,16 @@ public:
 	void input(sint16 data);
 	void input(uint32 data);
 	void input(sint32 data);
+	void input(uint64 data);
+	void input(sint64 data);
 	void input(const char *data);
 	const char* get_str(const int maxlen=20) const;
 
+	/**
+	 * the first four bytes of the digest, to be compared and sent often
+	 */
+	uint32 get_short_digest();
+
 	// templated to be able to read/write from/to loadsave_t and packet_t
 	template<class rdwr_able> void rdwr(rdwr_able *file)
 	{
@@ -32,6 +32,9 @@ protected:
 public:
 	uint32 get_current_index() const { return index; }
 
+	/// number of bytes left to read or write
+	uint32 get_remaining() const { return max_size - index; }
+
 	bool is_saving() const { return saving; }
 	bool is_loading() const { return !saving; }
 
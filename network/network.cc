@@ -502,8 +502,74 @@ network_command_t* network_get_received_command()
  * - server: accept connection to a new client
  * - all: receive commands and puts them to the received_command_queue
  */
+// accept a new connection on this server socket
+static void network_accept(SOCKET accept_sock)
+{
+	struct sockaddr_in client_name;
+	socklen_t size = sizeof(client_name);
+	SOCKET s = accept(accept_sock, (struct sockaddr *)&client_name, &size);
+	if(  s!=INVALID_SOCKET  ) {
+#if USE_WINSOCK
+		uint32 ip = ntohl((uint32)client_name.sin_addr.S_un.S_addr);
+#else
+		uint32 ip = ntohl((uint32)client_name.sin_addr.s_addr);
+#endif
+		if (blacklist.contains(net_address_t( ip ))) {
+			// refuse connection
+			network_close_socket(s);
+			return;
+		}
+#ifdef  __BEOS__
+		char name[256];
+		sprintf(name, "%lh", client_name.sin_addr.s_addr );
+#else
+		const char *name = inet_ntoa(client_name.sin_addr);
+#endif
+		dbg->message("check_activity()", "Accepted connection from: %s.",  name);
+		socket_list_t::add_client(s, ip);
+	}
+}
+
+
+// receive from this client socket
+static void network_receive_from(SOCKET sender)
+{
+	if (sender != INVALID_SOCKET  &&  socket_list_t::has_client(sender)) {
+		uint32 client_id = socket_list_t::get_client_id(sender);
+		network_command_t *nwc = socket_list_t::get_client(client_id).receive_nwc();
+		while (nwc) {
+			received_command_queue.append(nwc);
+			dbg->warning( "network_check_activity()", "received cmd id=%d %s from socket[%d]", nwc->get_id(), nwc->get_name(), sender );
+			// a compressed frame contains several commands
+			nwc = socket_list_t::has_client(sender) ? socket_list_t::get_client(client_id).get_unpacked_nwc() : NULL;
+		}
+		// errors are caught and treated in socket_info_t::receive_nwc
+	}
+}
+
+
 network_command_t* network_check_activity(karte_t *, int timeout)
 {
+#if USE_EPOLL
+	SOCKET ready[64];
+	const int action = socket_list_t::wait_readable( ready, lengthof(ready), timeout );
+	if(  action<=0  ) {
+		// timeout: return command from the queue
+		return network_get_received_command();
+	}
+
+	// accept new connections first, as with select below
+	for(  int i=0;  i<action;  i++  ) {
+		if(  socket_list_t::is_server_socket(ready[i])  ) {
+			network_accept(ready[i]);
+		}
+	}
+	for(  int i=0;  i<action;  i++  ) {
+		if(  !socket_list_t::is_server_socket(ready[i])  ) {
+			network_receive_from(ready[i]);
+		}
+	}
+#else
 	fd_set fds;
 	FD_ZERO(&fds);
 
@@ -526,53 +592,42 @@ network_command_t* network_check_activity(karte_t *, int timeout)
 		SOCKET accept_sock = iter_s.get_current();
 
 		if(  accept_sock!=INVALID_SOCKET  ) {
-			struct sockaddr_in client_name;
-			socklen_t size = sizeof(client_name);
-			SOCKET s = accept(accept_sock, (struct sockaddr *)&client_name, &size);
-			if(  s!=INVALID_SOCKET  ) {
-#if USE_WINSOCK
-				uint32 ip = ntohl((uint32)client_name.sin_addr.S_un.S_addr);
-#else
-				uint32 ip = ntohl((uint32)client_name.sin_addr.s_addr);
-#endif
-				if (blacklist.contains(net_address_t( ip ))) {
-					// refuse connection
-					network_close_socket(s);
-					continue;
-				}
-#ifdef  __BEOS__
-				char name[256];
-				sprintf(name, "%lh", client_name.sin_addr.s_addr );
-#else
-				const char *name = inet_ntoa(client_name.sin_addr);
-#endif
-				dbg->message("check_activity()", "Accepted connection from: %s.",  name);
-				socket_list_t::add_client(s, ip);
-			}
+			network_accept(accept_sock);
 		}
 	}
 
 	// receive from clients
 	socket_list_t::client_socket_iterator_t iter_c(&fds);
 	while(iter_c.next()) {
-		SOCKET sender = iter_c.get_current();
-
-		if (sender != INVALID_SOCKET  &&  socket_list_t::has_client(sender)) {
-			uint32 client_id = socket_list_t::get_client_id(sender);
-			network_command_t *nwc = socket_list_t::get_client(client_id).receive_nwc();
-			if (nwc) {
-				received_command_queue.append(nwc);
-				dbg->warning( "network_check_activity()", "received cmd id=%d %s from socket[%d]", nwc->get_id(), nwc->get_name(), sender );
-			}
-			// errors are caught and treated in socket_info_t::receive_nwc
-		}
+		network_receive_from(iter_c.get_current());
 	}
+#endif
 	return network_get_received_command();
 }
 
 
 void network_process_send_queues(int timeout)
 {
+#if NETWORK_NONBLOCKING_SEND
+	// sending does not block: a slow client only keeps its data in the queue,
+	// but never delays the game for all others
+	(void)timeout;
+	for(  uint32 i=0;  i<socket_list_t::get_count();  i++  ) {
+		socket_info_t &info = socket_list_t::get_client(i);
+		if(  info.has_pending_data()  ) {
+			info.process_send_queue();
+			// errors are caught and treated in socket_info_t::process_send_queue
+		}
+	}
+#else
+	// a client, which does not receive at all, never becomes writable
+	for(  uint32 i=0;  i<socket_list_t::get_count();  i++  ) {
+		socket_info_t &info = socket_list_t::get_client(i);
+		if(  info.has_pending_data()  &&  info.is_send_queue_full()  ) {
+			info.process_send_queue();
+		}
+	}
+
 	fd_set fds;
 	FD_ZERO(&fds);
 
@@ -602,6 +657,19 @@ void network_process_send_queues(int timeout)
 		}
 		action --;
 	}
+#endif
+}
+
+
+bool network_check_writable( SOCKET sock )
+{
+	fd_set fds;
+	FD_ZERO(&fds);
+	FD_SET(sock, &fds);
+	struct timeval tv;
+	tv.tv_sec = 0;
+	tv.tv_usec = 0;
+	return select( FD_SETSIZE, NULL, &fds, NULL, &tv ) == 1;
 }
 
 
@@ -683,7 +751,11 @@ bool network_send_data( SOCKET dest, const char *buf, const uint16 size, uint16
 {
 	count = 0;
 	while (count < size) {
+#if NETWORK_NONBLOCKING_SEND
+		int sent = send(dest, buf+count, size-count, timeout_ms <= 0 ? MSG_DONTWAIT : 0);
+#else
 		int sent = send(dest, buf+count, size-count, 0);
+#endif
 		if (sent == -1) {
 			int err = GET_LAST_ERROR();
 			if (err != EWOULDBLOCK) {
@@ -48,12 +48,25 @@
 // all non-windows
 #	include <fcntl.h>
 #	include <errno.h>
+
+// Linux: wait for activity with epoll, which neither scans all sockets nor is limited by FD_SETSIZE
+#	ifdef __linux__
+#		define USE_EPOLL 1
+#		include <sys/epoll.h>
+#	endif
 	// to keep compatibility to MS windows
 	typedef int SOCKET;
 #	define INVALID_SOCKET -1
 #	define GET_LAST_ERROR() (errno)
 #endif
 
+// sends without timeout never wait for a slow receiver (the sockets themselves are blocking)
+#ifdef MSG_DONTWAIT
+#	define NETWORK_NONBLOCKING_SEND 1
+#else
+#	define NETWORK_NONBLOCKING_SEND 0
+#endif
+
 #include "../simtypes.h"
 // version of network protocol code
 #define NETWORK_VERSION (1)
@@ -115,6 +128,9 @@ bool network_receive_data( SOCKET sender, void *dest, const uint16 len, uint16 &
 
 void network_process_send_queues(int timeout);
 
+// true, if data can be sent to this socket without blocking
+bool network_check_writable( SOCKET sock );
+
 // true, if I can wrinte on the server connection
 bool network_check_server_connection();
 
@@ -30,6 +30,7 @@ enum {
 	NWC_CHG_PLAYER,
 	NWC_SCENARIO,
 	NWC_SCENARIO_RULES,
+	NWC_FRAME,            // compressed packets, not a command (see socket_info_t)
 	NWC_COUNT
 };
 
@@ -5,6 +5,7 @@
 #include "network_socket_list.h"
 #include "network_cmp_pakset.h"
 #include "network_cmd_scenario.h"
+#include "network_journal.h"
 
 #include "../dataobj/loadsave.h"
 #include "../dataobj/gameinfo.h"
@@ -390,6 +391,12 @@ void nwc_join_t::rdwr()
 	nwc_nick_t::rdwr();
 	packet->rdwr_long(client_id);
 	packet->rdwr_byte(answer);
+	if(  packet->is_saving()  ||  packet->get_remaining() > 0  ) {
+		packet->rdwr_byte(framing);
+	}
+	else {
+		framing = 0;
+	}
 }
 
 
@@ -406,6 +413,8 @@ bool nwc_join_t::execute(karte_t *welt)
 			nwc_nick_t::execute(welt);
 			nwj.nickname = nickname;
 			socket_list_t::get_client(nwj.client_id).nickname = nickname;
+			// from now on the commands to this client may be compressed
+			socket_list_t::get_client(nwj.client_id).compress_frames = env_t::server_compress_frames  &&  (framing & FRAMES_COMPRESSED);
 		}
 
 		// no other joining process active?
@@ -610,6 +619,7 @@ network_world_command_t::network_world_command_t(uint16 id, uint32 sync_step, ui
 {
 	this->sync_step = sync_step;
 	this->map_counter = map_counter;
+	replayed = false;
 }
 
 
@@ -728,8 +738,8 @@ void nwc_sync_t::do_command(karte_t *welt)
 		welt->save( fn, loadsave_t::save_mode, SERVER_SAVEGAME_VER_NR, false );
 
 		// ok, now sending game
-		// this sends nwc_game_t
-		const char *err = network_send_file( client_id, fn );
+		// this sends nwc_game_t, the game itself is sent while the server continues
+		const char *err = network_stream_file( client_id, fn );
 		if (err) {
 			dbg->warning("nwc_sync_t::do_command","send game failed with: %s", err);
 		}
@@ -741,30 +751,33 @@ void nwc_sync_t::do_command(karte_t *welt)
 		// restore steps
 		welt->network_game_set_pause( false, old_sync_steps);
 
+		// the game just saved is also the checkpoint for crash recovery
+		if(  env_t::server_checkpoint_interval > 0  ) {
+			network_journal_t::start( welt->get_zeit_ms(), old_sync_steps, false );
+		}
+
 		// apply new map counter
 		welt->set_map_counter(new_map_counter);
 
 		// unpause the client that received the game
 		// we do not want to wait for him (maybe loading failed due to pakset-errors)
+		// everything is queued behind the game, so the client gets all commands since old_sync_steps to catch up
 		SOCKET sock = socket_list_t::get_socket(client_id);
-		if(  sock != INVALID_SOCKET  ) {
+		if(  sock != INVALID_SOCKET  &&  err == NULL  ) {
+			socket_info_t &info = socket_list_t::get_client(client_id);
 			nwc_ready_t nwc( old_sync_steps, welt->get_map_counter(), welt->get_checklist_at(old_sync_steps) );
-			if (nwc.send(sock)) {
-				socket_list_t::change_state( client_id, socket_info_t::playing);
-				if (socket_list_t::is_valid_client_id(client_id)) {
-					socket_list_t::get_client(client_id).player_unlocked = unlocked_players;
-					// send information about locked state
-					nwc_auth_player_t nwc;
-					nwc.player_unlocked = unlocked_players;
-					nwc.send(sock);
-
-					// welcome message
-					nwc_nick_t::server_tools(welt, client_id, nwc_nick_t::WELCOME, NULL);
-				}
-			}
-			else {
-				dbg->warning( "nwc_sync_t::do_command", "send of NWC_READY failed" );
-			}
+			nwc.prepare_to_send();
+			info.send_queue_append( nwc.copy_packet() );
+			socket_list_t::change_state( client_id, socket_info_t::playing);
+			info.player_unlocked = unlocked_players;
+			// send information about locked state
+			nwc_auth_player_t nwa;
+			nwa.player_unlocked = unlocked_players;
+			nwa.prepare_to_send();
+			info.send_queue_append( nwa.copy_packet() );
+
+			// welcome message
+			nwc_nick_t::server_tools(welt, client_id, nwc_nick_t::WELCOME, NULL);
 		}
 		nwc_join_t::pending_join_client = INVALID_SOCKET;
 	}
@@ -785,6 +798,10 @@ void nwc_check_t::rdwr()
 	network_world_command_t::rdwr();
 	server_checklist.rdwr(packet);
 	packet->rdwr_long(server_sync_step);
+	// older servers do not send the digest
+	if(  packet->is_saving()  ||  packet->get_remaining() > 0  ) {
+		server_checklist.rdwr_digest(packet);
+	}
 	if (packet->is_loading()  &&  env_t::server) {
 		// server does not receive nwc_check_t-commands
 		packet->failed();
@@ -797,8 +814,8 @@ void network_broadcast_world_command_t::rdwr()
 	network_world_command_t::rdwr();
 	packet->rdwr_bool(exec);
 
-	if (packet->is_loading()  &&  env_t::server  &&  exec) {
-		// server does not receive exec-commands
+	if (packet->is_loading()  &&  env_t::server  &&  exec  &&  packet->get_sender()!=INVALID_SOCKET) {
+		// server does not receive exec-commands (but replays them from its journal)
 		packet->failed();
 	}
 }
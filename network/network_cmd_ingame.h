@@ -101,7 +101,7 @@ private:
 class nwc_join_t : public nwc_nick_t {
 public:
 	nwc_join_t(const char* nick=NULL)
-	: nwc_nick_t(nick), client_id(0), answer(0) { id = NWC_JOIN; }
+	: nwc_nick_t(nick), client_id(0), answer(0), framing(FRAMES_COMPRESSED) { id = NWC_JOIN; }
 
 	virtual bool execute(karte_t *);
 	virtual void rdwr();
@@ -109,6 +109,10 @@ public:
 	uint32 client_id;
 	uint8 answer;
 
+	/// the client can read these kinds of frames (older clients do not send this)
+	enum { FRAMES_COMPRESSED = 1 };
+	uint8 framing;
+
 	/**
 	 * this clients is in the process of joining
 	 */
@@ -167,7 +171,7 @@ public:
  */
 class network_world_command_t : public network_command_t {
 public:
-	network_world_command_t() : network_command_t(), sync_step(0), map_counter(0) {};
+	network_world_command_t() : network_command_t(), sync_step(0), map_counter(0), replayed(false) {};
 	network_world_command_t(uint16 /*id*/, uint32 /*sync_step*/, uint32 /*map_counter*/);
 	virtual void rdwr();
 	virtual const char* get_name() { return "network_world_command_t";}
@@ -177,6 +181,9 @@ public:
 	virtual void do_command(karte_t*) {}
 	uint32 get_sync_step() const { return sync_step; }
 	uint32 get_map_counter() const { return map_counter; }
+	// command was read from the journal of the server: execute it at this step in this world
+	void set_replayed(uint32 sync_step_, uint32 map_counter_) { sync_step = sync_step_; map_counter = map_counter_; replayed = true; }
+	bool is_replayed() const { return replayed; }
 	// ignore events that lie in the past?
 	// if false: any cmd with sync_step < world->sync_step forces network disconnect
 	virtual bool ignore_old_events() const { return false;}
@@ -186,6 +193,7 @@ public:
 protected:
 	uint32 sync_step; // when this has to be executed
 	uint32 map_counter; // cmd comes from world at this stage
+	bool replayed; // not sent, see network_journal_t
 	// TODO: uint16 sub_step to have an order within one step
 };
 
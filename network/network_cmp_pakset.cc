@@ -9,13 +9,18 @@
 
 #include <stdlib.h>
 
-stringhashtable_tpl<checksum_t*>::iterator nwc_pakset_info_t::server_iterator;
+vector_tpl<const char*> nwc_pakset_info_t::server_names;
+uint32 nwc_pakset_info_t::server_index = 0;
 SOCKET nwc_pakset_info_t::server_receiver = INVALID_SOCKET;
 
+// the client compares by the hash tree: it asks for several buckets and quits itself
+static bool server_by_tree = false;
+
 
 nwc_pakset_info_t::~nwc_pakset_info_t()
 {
 	delete chk;
+	delete [] hashes;
 	free(name);
 }
 
@@ -40,8 +45,13 @@ bool nwc_pakset_info_t::execute(karte_t *)
 					break;
 				}
 				server_receiver = packet->get_sender();
-				// restart iterator
-				server_iterator = pakset_info_t::info.begin();
+				// older clients want all besch's after this
+				server_names.clear();
+				FOR(stringhashtable_tpl<checksum_t*>, const& i, pakset_info_t::info) {
+					server_names.append(i.key);
+				}
+				server_index = 0;
+				server_by_tree = false;
 
 				nwi.flag = SV_PAKSET;
 				nwi.chk = new checksum_t(*pakset_info_t::get_checksum());
@@ -51,17 +61,45 @@ bool nwc_pakset_info_t::execute(karte_t *)
 				break;
 			}
 
+			case CL_WANT_HASHES: // client wants to compare a node of the hash tree
+				if (packet->get_sender() != server_receiver  ||  node > pakset_info_t::TREE_ROOT) {
+					break;
+				}
+				server_by_tree = true;
+				nwi.flag = SV_HASHES;
+				nwi.node = node;
+				nwi.hashes = new checksum_t[pakset_info_t::TREE_FANOUT];
+				for(int i=0; i<pakset_info_t::TREE_FANOUT; i++) {
+					nwi.hashes[i] = pakset_info_t::get_children(node)[i];
+				}
+				send = true;
+				break;
+
+			case CL_WANT_BUCKET: // client wants the besch's of one bucket
+				if (packet->get_sender() != server_receiver) {
+					break;
+				}
+				server_names.clear();
+				FOR(stringhashtable_tpl<checksum_t*>, const& i, pakset_info_t::info) {
+					if (pakset_info_t::get_bucket(i.key) == node) {
+						server_names.append(i.key);
+					}
+				}
+				server_index = 0;
+				server_by_tree = true;
+				// send the first one
+				// fall through
 			case CL_WANT_NEXT: // client received one info packet, wants next
-				if (server_iterator != pakset_info_t::info.end()) {
+				if (server_index < server_names.get_count()) {
+					const char *key = server_names[server_index++];
 					nwi.flag = SV_DATA;
-					nwi.chk  = new checksum_t(*server_iterator->value);
-					nwi.name = strdup(server_iterator->key);
+					nwi.chk  = new checksum_t(*pakset_info_t::info.get(key));
+					nwi.name = strdup(key);
 					DBG_MESSAGE("nwc_pakset_info_t::execute", "send info about %s",nwi.name);
-					++server_iterator;
 				}
 				else {
 					nwi.flag = SV_LAST;
-					ready = true;
+					ready = !server_by_tree;
 				}
 				send = true;
 				break;
@@ -106,6 +144,111 @@ void nwc_pakset_info_t::rdwr()
 		}
 		chk->rdwr(packet);
 	}
+
+	// the hash tree is unknown to older versions
+	if(  packet->is_loading()  &&  packet->get_remaining() == 0  ) {
+		has_tree = false;
+		return;
+	}
+	has_tree = true;
+	packet->rdwr_byte(node);
+	bool has_hashes = hashes != NULL;
+	packet->rdwr_bool(has_hashes);
+	if(  has_hashes  ) {
+		if(  packet->is_loading()  ) {
+			hashes = new checksum_t[pakset_info_t::TREE_FANOUT];
+		}
+		for(  int i=0;  i<pakset_info_t::TREE_FANOUT;  i++  ) {
+			hashes[i].rdwr(packet);
+		}
+	}
+}
+
+
+#define MAX_WRONG_PAKS 10
+
+/**
+ * wait for nwc_pakset_info_t, ignore other commands
+ */
+static nwc_pakset_info_t *receive_pakset_info()
+{
+	for(uint8 i=0; i<5; i++) {
+		network_command_t* nwc = network_check_activity( NULL, 10000 );
+		if (nwc  &&  nwc->get_id() == NWC_PAKSETINFO) {
+			return (nwc_pakset_info_t*)nwc;
+		}
+		delete nwc;
+	}
+	dbg->warning("network_compare_pakset_with_server", "server did not answer");
+	return NULL;
+}
+
+
+/**
+ * compare the besch's sent by the server after request one by one with addons
+ * @return false if the communication failed
+ */
+static bool compare_besch_with_server(SOCKET s, nwc_pakset_info_t &request, stringhashtable_tpl<checksum_t*> &addons,
+	stringhashtable_tpl<checksum_t*> &missing, stringhashtable_tpl<checksum_t*> &different, uint16 &wrong_paks, uint32 &progress, loadingscreen_t &ls)
+{
+	if (!request.send(s)) {
+		return false;
+	}
+	while (wrong_paks<=MAX_WRONG_PAKS) {
+		nwc_pakset_info_t *nwi = receive_pakset_info();
+		if (nwi == NULL) {
+			return false;
+		}
+		if (nwi->flag != nwc_pakset_info_t::SV_DATA) {
+			// SV_LAST, or the server gave up
+			const bool ok = nwi->flag == nwc_pakset_info_t::SV_LAST;
+			delete nwi;
+			return ok;
+		}
+		checksum_t* chk = addons.remove(nwi->name);
+		if(chk) {
+			if((*chk)==(*(nwi->chk))) {
+				// found identical besch's
+			}
+			else {
+				different.put(nwi->name, nwi->chk);
+				nwi->clear();
+				wrong_paks++;
+			}
+			progress++;
+			ls.set_progress(progress);
+		}
+		else {
+			missing.put(nwi->name, nwi->chk);
+			nwi->clear();
+			wrong_paks++;
+		}
+		delete nwi;
+
+		nwc_pakset_info_t nwi_next(nwc_pakset_info_t::CL_WANT_NEXT);
+		if (wrong_paks<=MAX_WRONG_PAKS  &&  !nwi_next.send(s)) {
+			return false;
+		}
+	}
+	return true;
+}
+
+
+/**
+ * @return the TREE_FANOUT hashes of the children of node on the server, NULL on failure
+ */
+static nwc_pakset_info_t *receive_hashes(SOCKET s, uint8 node)
+{
+	nwc_pakset_info_t nwi(nwc_pakset_info_t::CL_WANT_HASHES, node);
+	if (!nwi.send(s)) {
+		return NULL;
+	}
+	nwc_pakset_info_t *answer = receive_pakset_info();
+	if (answer  &&  (answer->flag != nwc_pakset_info_t::SV_HASHES  ||  answer->node != node  ||  answer->hashes == NULL)) {
+		delete answer;
+		answer = NULL;
+	}
+	return answer;
 }
 
 
@@ -127,112 +270,77 @@ void network_compare_pakset_with_server(const char* cp, std::string &msg)
 				return;
 			}
 		}
-		// copy our info to addon
-		// ie treat all our pak's as if they were not present on the server
+		// our pak's not (yet) found on the server
 		stringhashtable_tpl<checksum_t*> addons;
-		{
-			FOR(stringhashtable_tpl<checksum_t*>, const& i, pakset_info_t::get_info()) {
-				addons.put(i.key, i.value);
-			}
-		}
 		//
 		stringhashtable_tpl<checksum_t*> missing, different;
 		// show progress bar
-		uint32 num_paks = addons.get_count()+1;
+		uint32 num_paks = pakset_info_t::get_info().get_count()+1;
 		uint32 progress = 0;
-#define MAX_WRONG_PAKS 10
 		uint16 wrong_paks=0;
-		if(num_paks>0) {
+		{
 			loadingscreen_t ls(translator::translate("Comparing pak files ..."), num_paks );
-			// communication loop
-			bool ready = false;
-			do {
-				nwc_pakset_info_t *nwi = NULL;
-				// wait for nwc_pakset_info_t, ignore other commands
-				for(uint8 i=0; i<5; i++) {
-					network_command_t* nwc = network_check_activity( NULL, 10000 );
-					if (nwc  &&  nwc->get_id() == NWC_PAKSETINFO) {
-						nwi = (nwc_pakset_info_t*)nwc;
-						break;
-					}
-					delete nwc;
-				}
 
-				if (nwi == NULL) {
-					dbg->warning("network_compare_pakset_with_server", "server did not answer");
-					nwc_pakset_info_t nwi_quit(nwc_pakset_info_t::CL_QUIT);
-					if (!nwi_quit.send(my_client_socket)) {
-						err = "send of NWC_PAKSETINFO failed";
-					}
-					break;
+			nwc_pakset_info_t *nwi = receive_pakset_info();
+			if (nwi == NULL  ||  nwi->flag != nwc_pakset_info_t::SV_PAKSET) {
+				// server busy or not answering
+			}
+			else if (pakset_info_t::get_pakset_checksum()==(*(nwi->chk))) {
+				// found identical paksets: nothing to compare
+			}
+			else if (nwi->has_tree) {
+				wrong_paks++;
+				// descend the hash tree only where it differs
+				nwc_pakset_info_t *root = receive_hashes(my_client_socket, pakset_info_t::TREE_ROOT);
+				if (root == NULL) {
+					err = "hash tree of pakset not received";
 				}
-				switch(nwi->flag) {
-					case nwc_pakset_info_t::SV_PAKSET:
-					{
-						if(pakset_info_t::get_pakset_checksum()==(*(nwi->chk))) {
-							// found identical paksets
-						}
-						else {
-							wrong_paks++;
-						}
-						progress++;
-						// request new data
-						nwc_pakset_info_t nwi_data(nwc_pakset_info_t::CL_WANT_NEXT);
-						if(!nwi_data.send(my_client_socket)) {
-							err = "send of NWC_PAKSETINFO failed";
-							ready = true;
-						}
+				for(int g=0; root  &&  g<pakset_info_t::TREE_FANOUT  &&  wrong_paks<=MAX_WRONG_PAKS  &&  err==NULL; g++) {
+					if (root->hashes[g] == pakset_info_t::get_children(pakset_info_t::TREE_ROOT)[g]) {
+						continue;
+					}
+					nwc_pakset_info_t *group = receive_hashes(my_client_socket, g);
+					if (group == NULL) {
+						err = "hash tree of pakset not received";
 						break;
 					}
-
-					case nwc_pakset_info_t::SV_DATA:
-					{
-						checksum_t* chk = addons.remove(nwi->name);
-						if(chk) {
-							if((*chk)==(*(nwi->chk))) {
-								// found identical besch's
-							}
-							else {
-								different.put(nwi->name, nwi->chk);
-								nwi->clear();
-								wrong_paks++;
-							}
-							progress++;
-						}
-						else {
-							missing.put(nwi->name, nwi->chk);
-							nwi->clear();
-							wrong_paks++;
+					for(int b=0; b<pakset_info_t::TREE_FANOUT  &&  wrong_paks<=MAX_WRONG_PAKS; b++) {
+						if (group->hashes[b] == pakset_info_t::get_children(g)[b]) {
+							continue;
 						}
-						nwc_pakset_info_t nwi_next;
-						if (wrong_paks<=MAX_WRONG_PAKS) {
-							// request new data
-							nwi_next.flag = nwc_pakset_info_t::CL_WANT_NEXT;
-						}
-						else {
-							nwi_next.flag = nwc_pakset_info_t::CL_QUIT;
+						const uint16 bucket = g*pakset_info_t::TREE_FANOUT + b;
+						FOR(stringhashtable_tpl<checksum_t*>, const& i, pakset_info_t::get_info()) {
+							if (pakset_info_t::get_bucket(i.key) == bucket) {
+								addons.put(i.key, i.value);
+							}
 						}
-						if(!nwi_next.send(my_client_socket)) {
+						nwc_pakset_info_t request(nwc_pakset_info_t::CL_WANT_BUCKET, (uint8)bucket);
+						if (!compare_besch_with_server(my_client_socket, request, addons, missing, different, wrong_paks, progress, ls)) {
 							err = "send of NWC_PAKSETINFO failed";
-							ready = true;
+							break;
 						}
-						break;
 					}
-
-					case nwc_pakset_info_t::SV_LAST:
-					case nwc_pakset_info_t::SV_ERROR:
-					default:
-						ready = true;
+					delete group;
 				}
-
-				// update progress bar
-				if( num_paks > 0 ) {
-					ls.set_progress(progress);
+				delete root;
+			}
+			else {
+				wrong_paks++;
+				// older server: compare all besch's,
+				// ie treat all our pak's as if they were not present on the server
+				FOR(stringhashtable_tpl<checksum_t*>, const& i, pakset_info_t::get_info()) {
+					addons.put(i.key, i.value);
 				}
-				delete nwi;
-
-			} while (!ready  &&  wrong_paks<=MAX_WRONG_PAKS);
+				nwc_pakset_info_t request(nwc_pakset_info_t::CL_WANT_NEXT);
+				if (!compare_besch_with_server(my_client_socket, request, addons, missing, different, wrong_paks, progress, ls)) {
+					err = "send of NWC_PAKSETINFO failed";
+				}
+			}
+			delete nwi;
 
+			// end the negotiation (older servers have ended it already after SV_LAST)
+			nwc_pakset_info_t nwi_quit(nwc_pakset_info_t::CL_QUIT);
+			nwi_quit.send(my_client_socket);
 		}
 		// now report the result
 		msg.append("<title>");
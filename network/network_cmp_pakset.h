@@ -18,7 +18,7 @@ void network_compare_pakset_with_server(const char* cp, std::string &msg);
  */
 class nwc_pakset_info_t : public network_command_t {
 public:
-	nwc_pakset_info_t(uint8 flag_=UNDEFINED) : network_command_t(NWC_PAKSETINFO), flag(flag_), name(NULL), chk(NULL) {}
+	nwc_pakset_info_t(uint8 flag_=UNDEFINED, uint8 node_=0) : network_command_t(NWC_PAKSETINFO), flag(flag_), name(NULL), chk(NULL), node(node_), hashes(NULL), has_tree(false) {}
 	~nwc_pakset_info_t();
 	virtual bool execute(karte_t *);
 	virtual void rdwr();
@@ -28,9 +28,12 @@ public:
 		CL_INIT       = 0, // client want pakset info
 		CL_WANT_NEXT  = 1, // client received one info packet, wants next
 		CL_QUIT       = 2, // client ends this negotiation
+		CL_WANT_HASHES= 3, // client wants the hashes of the children of node
+		CL_WANT_BUCKET= 4, // client wants the besch's of bucket node (then continues with CL_WANT_NEXT)
 		SV_ERROR      = 10, // server busy etc
 		SV_PAKSET     = 11, // server sends pakset checksum
 		SV_DATA       = 12, // server sends data
+		SV_HASHES     = 13, // server sends hashes of the children of node
 		SV_LAST       = 19, // server sends last info packet
 		UNDEFINED     = 255
 	};
@@ -40,8 +43,16 @@ public:
 	checksum_t *chk;
 	void clear() { name = NULL; chk = NULL; }
 
+	/// node of the hash tree (see pakset_info_t)
+	uint8 node;
+	/// pakset_info_t::TREE_FANOUT hashes of its children, or NULL
+	checksum_t *hashes;
+	/// the sender knows the hash tree (older versions do not send node and hashes)
+	bool has_tree;
+
 	// for the communication of the server with the client
-	static stringhashtable_tpl<checksum_t*>::iterator server_iterator;
+	static vector_tpl<const char*> server_names;
+	static uint32 server_index;
 	static SOCKET server_receiver;
 };
 
@@ -278,6 +278,36 @@ error:
 	return "Client closed connection during transfer";
 }
 
+const char *network_stream_file( uint32 client_id, const char *filename )
+{
+	FILE *fp = fopen(filename,"rb");
+	if (fp == NULL) {
+		dbg->warning("network_stream_file", "could not open file %s", filename);
+		return "Could not open file";
+	}
+	fseek(fp, 0, SEEK_END);
+	long length = (long)ftell(fp);
+	rewind(fp);
+	uint8 *data = new uint8[max(length,1L)];
+	const bool ok = fread(data, 1, length, fp) == (size_t)length;
+	fclose(fp);
+	if (!ok) {
+		delete [] data;
+		return "Could not read file";
+	}
+
+	// send size of file
+	nwc_game_t nwc(length);
+	SOCKET s = socket_list_t::get_socket(client_id);
+	if (s==INVALID_SOCKET  ||  !nwc.send(s)) {
+		delete [] data;
+		return "Client closed connection during transfer";
+	}
+	// the rest is done by network_process_send_queues()
+	socket_list_t::get_client(client_id).send_stream(data, length);
+	return NULL;
+}
+
 /*
   POST a message (poststr) to an HTTP server at the specified address and relative path (name)
   Optionally: Receive response to file localname
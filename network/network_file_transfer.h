@@ -21,6 +21,9 @@ const char* network_connect(const char *cp, karte_t *world);
 // sending file over network
 const char *network_send_file( uint32 client_id, const char *filename );
 
+// reads the file into memory and sends it in the background, before any further commands to this client
+const char *network_stream_file( uint32 client_id, const char *filename );
+
 // receive file (directly to disk)
 char const* network_receive_file(SOCKET const s, char const* const save_as, const sint32 length, const sint32 timeout=10000 );
 
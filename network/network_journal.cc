@@ -0,0 +1,236 @@
+#include "network_journal.h"
+#include "network_cmd_ingame.h"
+#include "network_packet.h"
+
+#include "../simdebug.h"
+#include "../simworld.h"
+#include "../dataobj/environment.h"
+
+#include <string.h>
+
+#define JOURNAL_MAGIC "SIMJOURN"
+#define JOURNAL_MAGIC_LEN (8)
+
+
+FILE *network_journal_t::file = NULL;
+FILE *network_journal_t::next_file = NULL;
+uint32 network_journal_t::offset = 0;
+bool network_journal_t::file_replayed = false;
+bool network_journal_t::failed = false;
+
+
+// all numbers are stored in intel byte order (as in the packets)
+static void set_uint16(uint8 *p, uint16 v)
+{
+	p[0] = (uint8)v;
+	p[1] = (uint8)(v >> 8);
+}
+
+
+static void set_uint32(uint8 *p, uint32 v)
+{
+	set_uint16( p, (uint16)v );
+	set_uint16( p+2, (uint16)(v >> 16) );
+}
+
+
+static uint16 get_uint16(const uint8 *p)
+{
+	return p[0] | (p[1] << 8);
+}
+
+
+static uint32 get_uint32(const uint8 *p)
+{
+	return get_uint16(p) | ((uint32)get_uint16(p+2) << 16);
+}
+
+
+static void journal_name(char *fn, const char *suffix)
+{
+	sprintf( fn, "server%d-journal.%s", env_t::server, suffix );
+}
+
+
+FILE *network_journal_t::open(const char *suffix, uint32 ticks, uint32 sync_step)
+{
+	char fn[256];
+	journal_name( fn, suffix );
+	FILE *f = fopen( fn, "wb" );
+	if(  f == NULL  ) {
+		dbg->warning( "network_journal_t::open()", "cannot write %s", fn );
+		return NULL;
+	}
+	uint8 head[JOURNAL_MAGIC_LEN+8];
+	memcpy( head, JOURNAL_MAGIC, JOURNAL_MAGIC_LEN );
+	set_uint32( head+JOURNAL_MAGIC_LEN, ticks );
+	set_uint32( head+JOURNAL_MAGIC_LEN+4, sync_step );
+	fwrite( head, 1, sizeof(head), f );
+	fflush( f );
+	return f;
+}
+
+
+void network_journal_t::start(uint32 ticks, uint32 sync_step, bool pending)
+{
+	if(  next_file  ) {
+		fclose( next_file );
+	}
+	next_file = open( "new", ticks, sync_step );
+	if(  next_file == NULL  ) {
+		failed = true;
+		return;
+	}
+	if(  !pending  ) {
+		commit( true );
+	}
+}
+
+
+void network_journal_t::commit(bool ok)
+{
+	if(  next_file == NULL  ) {
+		return;
+	}
+	char fn[256], next_fn[256];
+	journal_name( fn, "bin" );
+	journal_name( next_fn, "new" );
+	fclose( next_file );
+	next_file = NULL;
+	failed = !ok;
+	if(  !ok  ) {
+		// checkpoint failed: the old one is still valid
+		remove( next_fn );
+		return;
+	}
+	if(  file  ) {
+		fclose( file );
+	}
+	remove( fn );
+	rename( next_fn, fn );
+	file = fopen( fn, "ab" );
+	offset = 0;
+	file_replayed = false;
+}
+
+
+void network_journal_t::write(FILE *f, network_world_command_t *nwc, uint32 sync_step)
+{
+	const packet_t *p = nwc->get_packet();
+	const uint16 len = p->get_payload_len();
+	uint8 head[8];
+	set_uint32( head, sync_step );
+	set_uint16( head+4, nwc->get_id() );
+	set_uint16( head+6, len );
+	fwrite( head, 1, sizeof(head), f );
+	fwrite( p->get_payload(), 1, len, f );
+	// the journal is only useful, if it reaches the disk before a crash
+	fflush( f );
+}
+
+
+void network_journal_t::append(network_world_command_t *nwc)
+{
+	if(  nwc->get_packet() == NULL  ) {
+		return;
+	}
+	if(  file  &&  !(file_replayed  &&  nwc->is_replayed())  ) {
+		write( file, nwc, nwc->get_sync_step() + offset );
+	}
+	if(  next_file  ) {
+		write( next_file, nwc, nwc->get_sync_step() );
+	}
+}
+
+
+void network_journal_t::close()
+{
+	if(  file  ) {
+		fclose( file );
+		file = NULL;
+	}
+	if(  next_file  ) {
+		fclose( next_file );
+		next_file = NULL;
+	}
+	offset = 0;
+	file_replayed = false;
+	failed = false;
+}
+
+
+bool network_journal_t::replay_file(karte_t *welt, const char *suffix, uint32 &count)
+{
+	char fn[256];
+	journal_name( fn, suffix );
+	FILE *f = fopen( fn, "rb" );
+	if(  f == NULL  ) {
+		return false;
+	}
+	fseek( f, 0, SEEK_END );
+	const long len = ftell( f );
+	fseek( f, 0, SEEK_SET );
+	uint8 *buf = len >= JOURNAL_MAGIC_LEN+8 ? new uint8[len] : NULL;
+	const bool ok = buf  &&  fread( buf, 1, len, f ) == (size_t)len  &&  memcmp( buf, JOURNAL_MAGIC, JOURNAL_MAGIC_LEN ) == 0
+	                &&  get_uint32( buf+JOURNAL_MAGIC_LEN ) == welt->get_zeit_ms();
+	fclose( f );
+	if(  !ok  ) {
+		// not the journal of this checkpoint
+		delete [] buf;
+		return false;
+	}
+
+	// the loaded world starts again at its own sync_steps
+	const uint32 base = get_uint32( buf+JOURNAL_MAGIC_LEN+4 );
+	const uint32 now = welt->get_sync_steps();
+	long pos = JOURNAL_MAGIC_LEN+8;
+	count = 0;
+	while(  pos + 8 <= len  ) {
+		const uint32 sync_step = get_uint32( buf+pos );
+		const uint16 id = get_uint16( buf+pos+4 );
+		const uint16 data_len = get_uint16( buf+pos+6 );
+		if(  pos + 8 + data_len > len  ) {
+			// last record incomplete
+			break;
+		}
+		network_command_t *nwc = network_command_t::read_from_packet( new packet_t( id, buf+pos+8, data_len ) );
+		if(  network_world_command_t *nwwc = dynamic_cast<network_world_command_t *>(nwc)  ) {
+			nwwc->set_replayed( sync_step - base + now, welt->get_map_counter() );
+			if(  nwwc->execute(welt)  ) {
+				delete nwwc;
+			}
+			count++;
+		}
+		else {
+			delete nwc;
+		}
+		pos += 8 + data_len;
+	}
+
+	// continue this journal (without an incomplete record)
+	journal_name( fn, "bin" );
+	file = fopen( fn, "wb" );
+	if(  file  ) {
+		fwrite( buf, 1, pos, file );
+		fflush( file );
+	}
+	offset = base - now;
+	file_replayed = true;
+	delete [] buf;
+	return true;
+}
+
+
+uint32 network_journal_t::replay(karte_t *welt)
+{
+	close();
+	uint32 count = 0;
+	// the new journal is valid, if its checkpoint was written but not committed
+	if(  replay_file( welt, "bin", count )  ||  replay_file( welt, "new", count )  ) {
+		dbg->message( "network_journal_t::replay()", "%u commands since the last checkpoint", count );
+	}
+	char fn[256];
+	journal_name( fn, "new" );
+	remove( fn );
+	return count;
+}
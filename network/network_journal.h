@@ -0,0 +1,75 @@
+#ifndef _NETWORK_JOURNAL_H
+#define _NETWORK_JOURNAL_H
+
+#include "../simtypes.h"
+#include <stdio.h>
+
+class karte_t;
+class network_world_command_t;
+
+/**
+ * Journal of the server for crash recovery.
+ *
+ * server%d-network.sve is the last checkpoint. All tools and player changes
+ * executed after it are appended to server%d-journal.bin, together with their
+ * sync_step. After a restart the checkpoint is loaded and the journaled commands
+ * are put into the command queue again, with the same distance in sync_steps to
+ * the checkpoint as before.
+ *
+ * While a checkpoint is written in the background, the commands go into both
+ * the old journal and server%d-journal.new. The new journal replaces the old one,
+ * when the checkpoint was written successfully.
+ */
+class network_journal_t
+{
+	/// journal of the last written checkpoint
+	static FILE *file;
+	/// journal of the checkpoint still written in the background
+	static FILE *next_file;
+	/// added to the sync_steps before writing to file (after a restart)
+	static uint32 offset;
+	/// file was replayed after a restart: do not write the replayed commands again
+	static bool file_replayed;
+	/// the last checkpoint could not be written
+	static bool failed;
+
+	static FILE *open(const char *suffix, uint32 ticks, uint32 sync_step);
+	static void write(FILE *f, network_world_command_t *nwc, uint32 sync_step);
+
+	/// @return true, if the journal belongs to the loaded world (and was replayed)
+	static bool replay_file(karte_t *welt, const char *suffix, uint32 &count);
+
+public:
+	/**
+	 * A checkpoint of the world at this time was saved.
+	 * @param pending if true, it is still written in the background: see commit()
+	 */
+	static void start(uint32 ticks, uint32 sync_step, bool pending);
+
+	/**
+	 * The checkpoint written in the background is finished.
+	 * @param ok if false, it failed and the old journal stays valid
+	 */
+	static void commit(bool ok);
+
+	/// this command is executed now by the server
+	static void append(network_world_command_t *nwc);
+
+	/// @return true, if there is a journal or a checkpoint is written for a new one
+	static bool is_open() { return file != NULL  ||  next_file != NULL; }
+
+	/// @return true, if the last checkpoint failed: better wait before trying again
+	static bool has_failed() { return failed; }
+
+	/// stops journaling, e.g. for loading another game
+	static void close();
+
+	/**
+	 * The checkpoint was loaded after a restart: put the journaled commands
+	 * in the command queue and continue with this journal.
+	 * @return number of commands replayed
+	 */
+	static uint32 replay(karte_t *welt);
+};
+
+#endif
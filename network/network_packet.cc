@@ -2,6 +2,8 @@
 #include "network_packet.h"
 #include "network_socket_list.h"
 
+#include <string.h>
+
 
 void packet_t::rdwr_header()
 {
@@ -55,6 +57,22 @@ packet_t::packet_t(SOCKET sender) : memory_rw_t(buf,MAX_PACKET_LEN,false)
 }
 
 
+packet_t::packet_t(uint16 id_, const uint8 *data, uint16 len, SOCKET sender) : memory_rw_t(buf,MAX_PACKET_LEN,false)
+{
+	error = len > MAX_PACKET_LEN - HEADER_SIZE;
+	if(  !error  ) {
+		memcpy( buf + HEADER_SIZE, data, len );
+	}
+	size = count = error ? HEADER_SIZE : HEADER_SIZE + len;
+	version = NETWORK_VERSION;
+	id = id_;
+	sock = sender;
+	set_max_size(size);
+	set_index(HEADER_SIZE);
+	ready = true;
+}
+
+
 void packet_t::recv()
 {
 	if (error  ||  ready) {
@@ -99,11 +117,8 @@ void packet_t::recv()
 }
 
 
-void packet_t::send(SOCKET s, bool complete)
+const uint8 *packet_t::get_data()
 {
-	if (has_failed()) {
-		return;
-	}
 	// header written ?
 	if (size == 0) {
 		size = get_current_index();
@@ -112,6 +127,16 @@ void packet_t::send(SOCKET s, bool complete)
 		set_max_size(HEADER_SIZE);
 		rdwr_header();
 	}
+	return buf;
+}
+
+
+void packet_t::send(SOCKET s, bool complete)
+{
+	if (has_failed()) {
+		return;
+	}
+	get_data();
 
 	uint16 sent;
 	const int timeout_ms = complete ? 250 : 0;
@@ -48,6 +48,13 @@ public:
 	 */
 	packet_t(SOCKET s);
 
+	/**
+	 * constructor: packet is in loading-mode and ready
+	 * @param data stored payload, see get_payload()
+	 * @param sender socket, where the data were received
+	 */
+	packet_t(uint16 id, const uint8 *data, uint16 len, SOCKET sender=INVALID_SOCKET);
+
 	/**
 	 * start/continue sending
 	 * sets bools ready or error
@@ -73,6 +80,17 @@ public:
 
 	SOCKET get_sender() { return sock; }
 
+	/**
+	 * writes the header (if not done yet), no further data can be added
+	 * @return the complete packet with get_size() bytes
+	 */
+	const uint8 *get_data();
+	uint16 get_size() const { return size; }
+
+	/// the data after the header (written so far or received)
+	const uint8 *get_payload() const { return buf + HEADER_SIZE; }
+	uint16 get_payload_len() const { return (size ? size : get_current_index()) - HEADER_SIZE; }
+
 	/**
 	 * mark this packet as sent by the server
 	 * @see network_send_server
@@ -5,8 +5,22 @@
 
 #ifndef NETTOOL
 #include "../dataobj/environment.h"
+// the input of the streams is const
+#define ZLIB_CONST
+#include <zlib.h>
 #endif
 
+#include <string.h>
+
+// packets coalesced into one send call, must fit into uint16 for network_send_data()
+#define BATCH_SIZE (4*MAX_PACKET_LEN)
+// uncompressed data of one frame: leaves room for the deflate overhead of incompressible data
+#define FRAME_RAW_SIZE (MAX_PACKET_LEN-HEADER_SIZE-256)
+// a client, which does not take more than this packets, is too slow to stay in sync
+// (also while it still receives the game: with the check commands of the default sync rate
+//  this limit is only reached by a transfer lasting more than an hour)
+#define MAX_SEND_QUEUE (4096)
+
 
 bool connection_info_t::operator==(const connection_info_t& other) const
 {
@@ -22,6 +36,28 @@ void socket_info_t::reset()
 		packet_t *p = send_queue.remove_first();
 		delete p;
 	}
+	delete [] stream;
+	stream = NULL;
+	stream_len = stream_pos = 0;
+	delete [] batch;
+	batch = NULL;
+	batch_len = batch_pos = 0;
+	while(!unpacked.empty()) {
+		delete unpacked.remove_first();
+	}
+#ifndef NETTOOL
+	if (deflate_stream) {
+		deflateEnd(deflate_stream);
+		delete deflate_stream;
+		deflate_stream = NULL;
+	}
+	if (inflate_stream) {
+		inflateEnd(inflate_stream);
+		delete inflate_stream;
+		inflate_stream = NULL;
+	}
+#endif
+	compress_frames = false;
 	if (socket != INVALID_SOCKET) {
 		network_close_socket(socket);
 	}
@@ -49,6 +85,17 @@ network_command_t* socket_info_t::receive_nwc()
 		socket_list_t::remove_client(socket);
 	}
 	else if (packet->is_ready()) {
+		if (packet->get_id() == NWC_FRAME) {
+			packet_t *frame = packet;
+			packet = NULL;
+			const bool ok = unpack_frame(frame);
+			delete frame;
+			if (!ok) {
+				socket_list_t::remove_client(socket);
+				return NULL;
+			}
+			return get_unpacked_nwc();
+		}
 		// create command
 		network_command_t *nwc = network_command_t::read_from_packet(packet);
 		// the network_command takes care of deleting packet
@@ -59,25 +106,205 @@ network_command_t* socket_info_t::receive_nwc()
 }
 
 
-void socket_info_t::process_send_queue()
+network_command_t* socket_info_t::get_unpacked_nwc()
 {
-	while(!send_queue.empty()) {
-		packet_t *p = send_queue.front();
-		p->send(socket, false);
-		if (p->has_failed()) {
-			// close this client, clear the send_queue
-			socket_list_t::remove_client(socket);
+	return unpacked.empty() ? NULL : unpacked.remove_first();
+}
+
+
+bool socket_info_t::unpack_frame(packet_t *frame)
+{
+#ifndef NETTOOL
+	if (inflate_stream == NULL) {
+		inflate_stream = new z_stream;
+		memset(inflate_stream, 0, sizeof(z_stream));
+		if (inflateInit(inflate_stream) != Z_OK) {
+			delete inflate_stream;
+			inflate_stream = NULL;
+			return false;
+		}
+	}
+	uint8 raw[MAX_PACKET_LEN];
+	inflate_stream->next_in = (const Bytef *)frame->get_payload();
+	inflate_stream->avail_in = frame->get_payload_len();
+	inflate_stream->next_out = raw;
+	inflate_stream->avail_out = sizeof(raw);
+	const int ret = inflate(inflate_stream, Z_SYNC_FLUSH);
+	if ((ret != Z_OK  &&  ret != Z_BUF_ERROR)  ||  inflate_stream->avail_in != 0) {
+		dbg->warning("socket_info_t::unpack_frame", "corrupt frame from socket[%d]", socket);
+		return false;
+	}
+	const uint32 len = sizeof(raw) - inflate_stream->avail_out;
+
+	// the frame contains complete packets: size, version and id in intel byte order, then the payload
+	uint32 pos = 0;
+	while (pos + HEADER_SIZE <= len) {
+		const uint16 size = raw[pos] | (raw[pos+1] << 8);
+		const uint16 id = raw[pos+4] | (raw[pos+5] << 8);
+		if (size < HEADER_SIZE  ||  pos + size > len  ||  id == NWC_FRAME) {
 			break;
 		}
-		else if (p->is_ready()) {
-			// packet complete sent, remove from queue
-			send_queue.remove_first();
-			delete p;
-			// proceed with next packet
+		network_command_t *nwc = network_command_t::read_from_packet(new packet_t(id, raw + pos + HEADER_SIZE, size - HEADER_SIZE, socket));
+		if (nwc) {
+			unpacked.append(nwc);
 		}
-		else {
+		pos += size;
+	}
+	if (pos != len) {
+		dbg->warning("socket_info_t::unpack_frame", "broken packet in frame from socket[%d]", socket);
+		return false;
+	}
+	return true;
+#else
+	(void)frame;
+	return false;
+#endif
+}
+
+
+bool socket_info_t::compress_frame(const uint8 *raw, uint32 len)
+{
+#ifndef NETTOOL
+	if (deflate_stream == NULL) {
+		deflate_stream = new z_stream;
+		memset(deflate_stream, 0, sizeof(z_stream));
+		if (deflateInit(deflate_stream, Z_DEFAULT_COMPRESSION) != Z_OK) {
+			delete deflate_stream;
+			deflate_stream = NULL;
+			return false;
+		}
+	}
+	uint8 *frame = batch + batch_len;
+	deflate_stream->next_in = (const Bytef *)raw;
+	deflate_stream->avail_in = len;
+	deflate_stream->next_out = frame + HEADER_SIZE;
+	deflate_stream->avail_out = MAX_PACKET_LEN - HEADER_SIZE;
+	// sync flush: the frame can be inflated on its own, but the history remains for the next one
+	if (deflate(deflate_stream, Z_SYNC_FLUSH) != Z_OK  ||  deflate_stream->avail_in != 0  ||  deflate_stream->avail_out == 0) {
+		return false;
+	}
+	const uint16 size = MAX_PACKET_LEN - deflate_stream->avail_out;
+	const uint16 header[3] = { size, NETWORK_VERSION, NWC_FRAME };
+	for (int i = 0; i < 3; i++) {
+		frame[2*i]   = (uint8)header[i];
+		frame[2*i+1] = (uint8)(header[i] >> 8);
+	}
+	batch_len += size;
+	return true;
+#else
+	(void)raw;
+	(void)len;
+	return false;
+#endif
+}
+
+
+bool socket_info_t::fill_batch()
+{
+	if (batch == NULL) {
+		batch = new uint8[BATCH_SIZE];
+	}
+	batch_len = batch_pos = 0;
+	while (!send_queue.empty()) {
+		packet_t *p = send_queue.front();
+		const uint8 *data = p->get_data();
+		uint16 size = p->get_size();
+
+		if (compress_frames  &&  size <= FRAME_RAW_SIZE) {
+			// a frame never gets larger than a packet
+			if (batch_len + MAX_PACKET_LEN > BATCH_SIZE) {
+				break;
+			}
+			uint8 raw[FRAME_RAW_SIZE];
+			uint32 raw_len = 0;
+			do {
+				memcpy(raw + raw_len, data, size);
+				raw_len += size;
+				send_queue.remove_first();
+				delete p;
+				if (send_queue.empty()) {
+					break;
+				}
+				p = send_queue.front();
+				data = p->get_data();
+				size = p->get_size();
+			} while (raw_len + size <= FRAME_RAW_SIZE);
+
+			if (!compress_frame(raw, raw_len)) {
+				// send these packets as they are and stop compressing
+				dbg->warning("socket_info_t::fill_batch", "compression failed for socket[%d]", socket);
+				memcpy(batch + batch_len, raw, raw_len);
+				batch_len += raw_len;
+				compress_frames = false;
+			}
+			continue;
+		}
+
+		if (batch_len + size > BATCH_SIZE) {
 			break;
 		}
+		memcpy(batch + batch_len, data, size);
+		batch_len += size;
+		send_queue.remove_first();
+		delete p;
+	}
+	return batch_len > 0;
+}
+
+
+bool socket_info_t::is_send_queue_full() const
+{
+	return send_queue.get_count() > MAX_SEND_QUEUE;
+}
+
+
+void socket_info_t::process_send_queue()
+{
+	// the queue grows also while the stream is sent, so check before
+	if (is_send_queue_full()) {
+		dbg->warning("socket_info_t::process_send_queue", "socket[%d] does not receive, %u packets waiting, %u of %u bytes of stream sent", socket, send_queue.get_count(), stream_pos, stream_len);
+		socket_list_t::remove_client(socket);
+		return;
+	}
+	if (stream) {
+		// send as much as possible without blocking
+		do {
+			uint16 sent;
+			const uint16 len = (uint16)min( stream_len - stream_pos, (uint32)MAX_PACKET_LEN );
+			if (!network_send_data(socket, (const char *)stream + stream_pos, len, sent, 0)) {
+				// close this client, clear the send_queue
+				socket_list_t::remove_client(socket);
+				return;
+			}
+			stream_pos += sent;
+			if (sent < len) {
+				// continue later
+				return;
+			}
+		} while (stream_pos < stream_len  &&  network_check_writable(socket));
+
+		if (stream_pos < stream_len) {
+			return;
+		}
+		dbg->message("socket_info_t::process_send_queue", "sent stream of %u bytes to socket[%d]", stream_len, socket);
+		delete [] stream;
+		stream = NULL;
+		stream_len = stream_pos = 0;
+	}
+	// the packets are sent in batches: fewer system calls, and the client gets them in less tcp segments
+	while (batch_pos < batch_len  ||  fill_batch()) {
+		uint16 sent;
+		const uint16 len = (uint16)(batch_len - batch_pos);
+		if (!network_send_data(socket, (const char *)batch + batch_pos, len, sent, 0)) {
+			// close this client, clear the send_queue
+			socket_list_t::remove_client(socket);
+			return;
+		}
+		batch_pos += sent;
+		if (sent < len) {
+			// continue later
+			return;
+		}
 	}
 }
 
@@ -94,6 +321,15 @@ void socket_info_t::send_queue_append(packet_t *p)
 	}
 }
 
+void socket_info_t::send_stream(uint8 *data, uint32 len)
+{
+	assert(stream == NULL);
+	stream = data;
+	stream_len = len;
+	stream_pos = 0;
+}
+
+
 void socket_info_t::rdwr(packet_t *p)
 {
 	address.rdwr(p);
@@ -114,6 +350,42 @@ uint32 socket_list_t::playing_clients;
  */
 uint32 socket_list_t::server_sockets;
 
+#if USE_EPOLL
+int socket_list_t::epoll_fd = -1;
+
+
+void socket_list_t::epoll_add( SOCKET sock )
+{
+	if(  epoll_fd < 0  ) {
+		epoll_fd = epoll_create( 64 );
+		if(  epoll_fd < 0  ) {
+			dbg->fatal("socket_list_t::epoll_add", "cannot create epoll instance (%s)", strerror(errno));
+		}
+	}
+	struct epoll_event ev;
+	ev.events = EPOLLIN;
+	ev.data.fd = sock;
+	if(  epoll_ctl( epoll_fd, EPOLL_CTL_ADD, sock, &ev ) != 0  &&  errno != EEXIST  ) {
+		dbg->warning("socket_list_t::epoll_add", "cannot watch socket[%d] (%s)", sock, strerror(errno));
+	}
+}
+
+
+int socket_list_t::wait_readable( SOCKET *ready, int max_count, int timeout_ms )
+{
+	if(  epoll_fd < 0  ) {
+		// nothing to wait for
+		return 0;
+	}
+	struct epoll_event ev[64];
+	int n = epoll_wait( epoll_fd, ev, min( max_count, 64 ), max( timeout_ms, 0 ) );
+	for(  int i=0;  i<n;  i++  ) {
+		ready[i] = ev[i].data.fd;
+	}
+	return max( n, 0 );
+}
+#endif
+
 /**
  * book-keeping for the number of connected / playing clients
  */
@@ -187,6 +459,9 @@ void socket_list_t::add_client( SOCKET sock, uint32 ip )
 	change_state( i, socket_info_t::connected );
 
 	network_set_socket_nodelay( sock );
+#if USE_EPOLL
+	epoll_add( sock );
+#endif
 }
 
 
@@ -224,6 +499,9 @@ void socket_list_t::add_server( SOCKET sock )
 	}
 
 	network_set_socket_nodelay( sock );
+#if USE_EPOLL
+	epoll_add( sock );
+#endif
 }
 
 
@@ -259,6 +537,17 @@ bool socket_list_t::has_client( SOCKET sock )
 }
 
 
+bool socket_list_t::is_server_socket( SOCKET sock )
+{
+	for(uint32 j=0; j<server_sockets; j++) {
+		if (list[j]->socket == sock  &&  list[j]->state == socket_info_t::server) {
+			return true;
+		}
+	}
+	return false;
+}
+
+
 uint32 socket_list_t::get_client_id( SOCKET sock ){
 	for(uint32 j=0; j<list.get_count(); j++) {
 		if (list[j]->state != socket_info_t::inactive  &&  list[j]->socket == sock) {
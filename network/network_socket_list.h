@@ -9,6 +9,7 @@
 
 class network_command_t;
 class packet_t;
+struct z_stream_s;
 
 
 /**
@@ -43,6 +44,34 @@ private:
 	packet_t *packet;
 	slist_tpl<packet_t *> send_queue;
 
+	/// raw data sent before the send queue (the game for a joining client)
+	uint8 *stream;
+	uint32 stream_len;
+	uint32 stream_pos;
+
+	/// packets of the send queue coalesced into one send call
+	uint8 *batch;
+	uint32 batch_len;
+	uint32 batch_pos;
+
+	/// the zlib streams of the compressed frames, the history serves as common dictionary
+	z_stream_s *deflate_stream;
+	z_stream_s *inflate_stream;
+
+	/// commands unpacked from a received frame, not yet returned by receive_nwc()
+	slist_tpl<network_command_t *> unpacked;
+
+	/**
+	 * moves the next packets from the send queue into batch
+	 * @return false if there is nothing to send
+	 */
+	bool fill_batch();
+
+	/// compresses len bytes from raw into a NWC_FRAME packet in batch
+	bool compress_frame(const uint8 *raw, uint32 len);
+
+	/// adds the commands in this NWC_FRAME packet to unpacked
+	bool unpack_frame(packet_t *frame);
 
 public:
 	enum {
@@ -57,7 +86,14 @@ public:
 
 	SOCKET socket;
 
-	socket_info_t() : connection_info_t(), packet(0), send_queue(), state(inactive), socket(INVALID_SOCKET), player_unlocked(0) {}
+	/**
+	 * packets to this client are sent as compressed NWC_FRAME packets
+	 * (only if the client can read them, see nwc_join_t)
+	 */
+	bool compress_frames;
+
+	socket_info_t() : connection_info_t(), packet(0), send_queue(), stream(NULL), stream_len(0), stream_pos(0), batch(NULL), batch_len(0), batch_pos(0),
+		deflate_stream(NULL), inflate_stream(NULL), state(inactive), socket(INVALID_SOCKET), compress_frames(false), player_unlocked(0) {}
 
 	~socket_info_t();
 
@@ -76,6 +112,12 @@ public:
 	 */
 	network_command_t* receive_nwc();
 
+	/**
+	 * a compressed frame may contain several commands
+	 * @return the next one, which was not yet returned by receive_nwc()
+	 */
+	network_command_t* get_unpacked_nwc();
+
 	/**
 	 *
 	 */
@@ -83,6 +125,23 @@ public:
 
 	void send_queue_append(packet_t *p);
 
+	/**
+	 * Sends these data as they are, before all packets in the send queue.
+	 * They are sent piecewise by process_send_queue(), so the game continues meanwhile.
+	 * @param data allocated with new [], will be deleted when sent
+	 */
+	void send_stream(uint8 *data, uint32 len);
+
+	bool is_streaming() const { return stream != NULL; }
+
+	/// something is waiting to be sent by process_send_queue()
+	bool has_pending_data() const {
+		return socket != INVALID_SOCKET  &&  state != inactive  &&  (stream  ||  batch_pos < batch_len  ||  !send_queue.empty());
+	}
+
+	/// the client does not receive fast enough, process_send_queue() will remove it
+	bool is_send_queue_full() const;
+
 	/**
 	 * rdwr client information to packet
 	 */
@@ -192,6 +251,23 @@ public:
 private:
 	static void book_state_change(uint8 state, sint8 incr);
 
+#if USE_EPOLL
+	/// all sockets in the list are registered (closed ones are removed by the kernel)
+	static int epoll_fd;
+	static void epoll_add(SOCKET sock);
+
+public:
+	/**
+	 * waits until sockets can be read (or accept a connection)
+	 * @param ready gets these sockets
+	 * @return their number, 0 on timeout
+	 */
+	static int wait_readable(SOCKET *ready, int max_count, int timeout_ms);
+#endif
+
+public:
+	static bool is_server_socket( SOCKET sock );
+
 public: // from now stuff to deal with fd_set's
 
 	/**
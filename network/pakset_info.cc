@@ -5,6 +5,8 @@
 
 stringhashtable_tpl<checksum_t*> pakset_info_t::info;
 checksum_t pakset_info_t::general;
+checksum_t pakset_info_t::groups[TREE_FANOUT];
+checksum_t pakset_info_t::buckets[TREE_BUCKETS];
 
 void pakset_info_t::append(const char* name, checksum_t *chk)
 {
@@ -23,6 +25,17 @@ void pakset_info_t::debug()
 }
 
 
+uint16 pakset_info_t::get_bucket(const char* name)
+{
+	// FNV-1a on the bytes of the name
+	uint32 hash = 2166136261u;
+	for(  const uint8 *p = (const uint8 *)name;  *p;  p++  ) {
+		hash = (hash ^ *p) * 16777619u;
+	}
+	return (uint16)(hash % TREE_BUCKETS);
+}
+
+
 /**
  * order all pak checksums by name
  */
@@ -42,6 +55,9 @@ bool entry_cmp(entry_t a, entry_t b)
 void pakset_info_t::calculate_checksum()
 {
 	general.reset();
+	for(  int b=0;  b<TREE_BUCKETS;  b++  ) {
+		buckets[b].reset();
+	}
 
 	// first sort all the besch's
 	vector_tpl<entry_t> sorted(info.get_count());
@@ -51,6 +67,19 @@ void pakset_info_t::calculate_checksum()
 	// now loop
 	FOR(vector_tpl<entry_t>, const& i, sorted) {
 		i.chk->calc_checksum(&general);
+		checksum_t &bucket = buckets[get_bucket(i.name)];
+		bucket.input(i.name);
+		i.chk->calc_checksum(&bucket);
 	}
 	general.finish();
+
+	// the tree above the buckets
+	for(  int g=0;  g<TREE_FANOUT;  g++  ) {
+		groups[g].reset();
+		for(  int b=0;  b<TREE_FANOUT;  b++  ) {
+			buckets[g*TREE_FANOUT + b].finish();
+			buckets[g*TREE_FANOUT + b].calc_checksum(&groups[g]);
+		}
+		groups[g].finish();
+	}
 }
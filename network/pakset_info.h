@@ -18,6 +18,22 @@ class pakset_info_t
 	 */
 	static checksum_t general;
 
+public:
+	/**
+	 * Hash tree of the pakset: the besch's are distributed into buckets by their names.
+	 * Server and client compare the groups, then the buckets of differing groups,
+	 * and only the besch's of differing buckets one by one.
+	 */
+	enum {
+		TREE_FANOUT  = 16,
+		TREE_BUCKETS = TREE_FANOUT*TREE_FANOUT,
+		TREE_ROOT    = TREE_FANOUT ///< node number of the root, nodes below are the groups
+	};
+
+private:
+	static checksum_t groups[TREE_FANOUT];
+	static checksum_t buckets[TREE_BUCKETS];
+
 public:
 	static const checksum_t& get_pakset_checksum() { return general; }
 	static const stringhashtable_tpl<checksum_t*>& get_info() { return info; }
@@ -27,6 +43,15 @@ public:
 
 	static void append(const char* name, checksum_t *chk);
 
+	/// bucket of this besch, the same on all platforms
+	static uint16 get_bucket(const char* name);
+
+	/**
+	 * @param node TREE_ROOT or a group
+	 * @return the TREE_FANOUT hashes of the children of this node (groups or buckets)
+	 */
+	static const checksum_t* get_children(uint8 node) { return node==TREE_ROOT ? groups : buckets + node*TREE_FANOUT; }
+
 	static void debug();
 
 	friend class nwc_pakset_info_t;
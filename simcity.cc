@@ -1803,21 +1803,21 @@ void stadt_t::step_passagiere()
 	const halthandle_t *const halt_list = plan->get_haltlist();
 
 	// suitable start search
-	static vector_tpl<halthandle_t> start_halts(16);
-	start_halts.clear();
+	const uint32 first_start_halt = pax_start_halts.get_count();
 	for (uint h = 0; h < plan->get_haltlist_count(); h++) {
 		halthandle_t halt = halt_list[h];
 		if(  halt.is_bound()  &&  halt->is_enabled(wtyp)  &&  !halt->is_overcrowded(wtyp->get_catg_index())  ) {
-			start_halts.append(halt);
+			pax_start_halts.append(halt);
 		}
 	}
+	const uint16 start_halt_count = pax_start_halts.get_count() - first_start_halt;
 
 	// Hajo: track number of generated passengers.
 	city_history_year[0][history_type+1] += num_pax;
 	city_history_month[0][history_type+1] += num_pax;
 
 	// only continue, if this is a good start halt
-	if (!start_halts.empty()) {
+	if (start_halt_count > 0) {
 		// Find passenger destination
 		for(  int pax_routed=0, pax_left_to_do=0;  pax_routed<num_pax;  pax_routed+=pax_left_to_do  ) {
 			// number of passengers that want to travel
@@ -1855,83 +1855,19 @@ void stadt_t::step_passagiere()
 
 			ware_t return_pax(wtyp);
 
-			// now, finally search a route; this consumes most of the time
-			int const route_result = haltestelle_t::search_route( &start_halts[0], start_halts.get_count(), welt->get_settings().is_no_routing_over_overcrowding(), pax, &return_pax);
-			halthandle_t start_halt = return_pax.get_ziel();
-			if(  route_result==haltestelle_t::ROUTE_OK  ) {
-				// register departed pax/mail at factory
-				if(  factory_entry  ) {
-					factory_entry->factory->book_stat( pax.menge, ( wtyp==warenbauer_t::passagiere ? FAB_PAX_DEPARTED : FAB_MAIL_DEPARTED ) );
-				}
-				// so we have happy traveling passengers
-				start_halt->starte_mit_route(pax);
-				start_halt->add_pax_happy(pax.menge);
-				// and show it
-				merke_passagier_ziel(dest_pos, COL_YELLOW);
-				city_history_year[0][history_type] += pax.menge;
-				city_history_month[0][history_type] += pax.menge;
-			}
-			else if(  route_result==haltestelle_t::ROUTE_WALK  ) {
-				if(  factory_entry  ) {
-					// workers who walk to the factory or customers who walk to the consumer store
-					factory_entry->factory->book_stat( pax_left_to_do, ( wtyp==warenbauer_t::passagiere ? FAB_PAX_DEPARTED : FAB_MAIL_DEPARTED ) );
-					factory_entry->factory->liefere_an(wtyp, pax_left_to_do);
-				}
-				// people who walk or mail delivered by hand do not count as transported or happy
-				start_halt->add_pax_walked(num_pax);
-			}
-			else if(  route_result==haltestelle_t::ROUTE_OVERCROWDED  ) {
-				merke_passagier_ziel(dest_pos, COL_ORANGE );
-				if (start_halt.is_bound()) {
-					start_halt->add_pax_unhappy(pax_left_to_do);
-					if(  will_return  ) {
-						pax.get_ziel()->add_pax_unhappy(pax_left_to_do);
-					}
-				}
-				else {
-					// all routes to goal are overcrowded -> register at all start halts
-					FOR(vector_tpl<halthandle_t>, const s, start_halts) {
-						s->add_pax_unhappy(pax_left_to_do);
-						merke_passagier_ziel(dest_pos, COL_ORANGE);
-					}
-				}
-			}
-			else {
-				// since there is no route from any start halt -> register no route at all start halts
-				FOR(vector_tpl<halthandle_t>, const s, start_halts) {
-					s->add_pax_no_route(pax_left_to_do);
-				}
-				merke_passagier_ziel(dest_pos, COL_DARK_ORANGE);
-#ifdef DESTINATION_CITYCARS
-				//citycars with destination
-				generate_private_cars(start_halt->get_basis_pos(), step_count, ziel);
-#endif
-			}
-
-			// send them also back
-			if(  route_result==haltestelle_t::ROUTE_OK  &&  will_return!=no_return  ) {
-				halthandle_t return_halt = pax.get_ziel();
-				if(  !return_halt->is_overcrowded( wtyp->get_catg_index() )  ) {
-					// prissi: not overcrowded and can receive => add them
-					if(  will_return!=city_return  &&  wtyp==warenbauer_t::post  ) {
-						// attractions/factory generate more mail than they receive
-						return_pax.menge = pax_left_to_do*3;
-					}
-					else {
-						// use normal amount for return pas/mail
-						return_pax.menge = pax_left_to_do;
-					}
-					return_pax.set_zielpos(origin_pos);
-
-					return_halt->starte_mit_route(return_pax);
-					return_halt->add_pax_happy(pax_left_to_do);
-				}
-				else {
-					// return halt crowded
-					return_halt->add_pax_unhappy(pax_left_to_do);
-				}
-			}
-			INT_CHECK( "simcity 1579" );
+			// now, finally search a route; this consumes most of the time, so it is done later for all cities at once
+			pax_packet_t packet;
+			packet.city = this;
+			packet.route_index = haltestelle_t::add_prepared_route( &pax_start_halts[first_start_halt], start_halt_count, welt->get_settings().is_no_routing_over_overcrowding(), pax, return_pax );
+			packet.first_start_halt = first_start_halt;
+			packet.start_halt_count = start_halt_count;
+			packet.origin_pos = origin_pos;
+			packet.dest_pos = dest_pos;
+			packet.will_return = will_return;
+			packet.factory = factory_entry ? factory_entry->factory : NULL;
+			packet.pax_left_to_do = pax_left_to_do;
+			packet.num_pax = num_pax;
+			pax_packets.append( packet );
 		}
 	}
 	else {
@@ -1971,6 +1907,119 @@ void stadt_t::step_passagiere()
 }
 
 
+vector_tpl<stadt_t::pax_packet_t> stadt_t::pax_packets;
+vector_tpl<halthandle_t> stadt_t::pax_start_halts;
+
+
+void stadt_t::route_passagiere()
+{
+	if(  pax_packets.empty()  ) {
+		pax_start_halts.clear();
+		return;
+	}
+
+	// the searches see all halts as they were after stepping the cities
+	haltestelle_t::prepare_routes();
+
+	// and the packets start in the order they were generated
+	FOR(vector_tpl<pax_packet_t>, const& packet, pax_packets) {
+		packet.city->book_passagiere(packet);
+		INT_CHECK( "simcity 1579" );
+	}
+
+	haltestelle_t::clear_prepared_routes();
+	pax_packets.clear();
+	pax_start_halts.clear();
+}
+
+
+void stadt_t::book_passagiere(const pax_packet_t &packet)
+{
+	ware_t pax, return_pax;
+	int const route_result = haltestelle_t::get_prepared_route( packet.route_index, pax, return_pax );
+
+	const ware_besch_t *const wtyp = pax.get_besch();
+	const int history_type = (wtyp == warenbauer_t::passagiere) ? HIST_PAS_TRANSPORTED : HIST_MAIL_TRANSPORTED;
+	const sint32 pax_left_to_do = packet.pax_left_to_do;
+	const koord dest_pos = packet.dest_pos;
+
+	halthandle_t start_halt = return_pax.get_ziel();
+	if(  route_result==haltestelle_t::ROUTE_OK  ) {
+		// register departed pax/mail at factory
+		if(  packet.factory  ) {
+			packet.factory->book_stat( pax.menge, ( wtyp==warenbauer_t::passagiere ? FAB_PAX_DEPARTED : FAB_MAIL_DEPARTED ) );
+		}
+		// so we have happy traveling passengers
+		start_halt->starte_mit_route(pax);
+		start_halt->add_pax_happy(pax.menge);
+		// and show it
+		merke_passagier_ziel(dest_pos, COL_YELLOW);
+		city_history_year[0][history_type] += pax.menge;
+		city_history_month[0][history_type] += pax.menge;
+	}
+	else if(  route_result==haltestelle_t::ROUTE_WALK  ) {
+		if(  packet.factory  ) {
+			// workers who walk to the factory or customers who walk to the consumer store
+			packet.factory->book_stat( pax_left_to_do, ( wtyp==warenbauer_t::passagiere ? FAB_PAX_DEPARTED : FAB_MAIL_DEPARTED ) );
+			packet.factory->liefere_an(wtyp, pax_left_to_do);
+		}
+		// people who walk or mail delivered by hand do not count as transported or happy
+		start_halt->add_pax_walked(packet.num_pax);
+	}
+	else if(  route_result==haltestelle_t::ROUTE_OVERCROWDED  ) {
+		merke_passagier_ziel(dest_pos, COL_ORANGE );
+		if (start_halt.is_bound()) {
+			start_halt->add_pax_unhappy(pax_left_to_do);
+			if(  packet.will_return  ) {
+				pax.get_ziel()->add_pax_unhappy(pax_left_to_do);
+			}
+		}
+		else {
+			// all routes to goal are overcrowded -> register at all start halts
+			for(  uint16 s=0;  s<packet.start_halt_count;  s++  ) {
+				pax_start_halts[packet.first_start_halt+s]->add_pax_unhappy(pax_left_to_do);
+				merke_passagier_ziel(dest_pos, COL_ORANGE);
+			}
+		}
+	}
+	else {
+		// since there is no route from any start halt -> register no route at all start halts
+		for(  uint16 s=0;  s<packet.start_halt_count;  s++  ) {
+			pax_start_halts[packet.first_start_halt+s]->add_pax_no_route(pax_left_to_do);
+		}
+		merke_passagier_ziel(dest_pos, COL_DARK_ORANGE);
+#ifdef DESTINATION_CITYCARS
+		//citycars with destination
+		generate_private_cars(start_halt->get_basis_pos(), step_count, ziel);
+#endif
+	}
+
+	// send them also back
+	if(  route_result==haltestelle_t::ROUTE_OK  &&  packet.will_return!=no_return  ) {
+		halthandle_t return_halt = pax.get_ziel();
+		if(  !return_halt->is_overcrowded( wtyp->get_catg_index() )  ) {
+			// prissi: not overcrowded and can receive => add them
+			if(  packet.will_return!=city_return  &&  wtyp==warenbauer_t::post  ) {
+				// attractions/factory generate more mail than they receive
+				return_pax.menge = pax_left_to_do*3;
+			}
+			else {
+				// use normal amount for return pas/mail
+				return_pax.menge = pax_left_to_do;
+			}
+			return_pax.set_zielpos(packet.origin_pos);
+
+			return_halt->starte_mit_route(return_pax);
+			return_halt->add_pax_happy(pax_left_to_do);
+		}
+		else {
+			// return halt crowded
+			return_halt->add_pax_unhappy(pax_left_to_do);
+		}
+	}
+}
+
+
 /**
  * returns a random and uniformly distributed point within city borders
  * @author Hj. Malthaner
@@ -9,6 +9,7 @@
 #define simcity_h
 
 #include "simobj.h"
+#include "halthandle_t.h"
 #include "obj/gebaeude.h"
 
 #include "tpl/vector_tpl.h"
@@ -18,6 +19,7 @@
 
 #include <string>
 
+class fabrik_t;
 class karte_ptr_t;
 class player_t;
 class rule_t;
@@ -310,10 +312,37 @@ private:
 
 	/**
 	 * verteilt die Passagiere auf die Haltestellen
+	 * Packets with a start halt are only generated here,
+	 * their routes are searched later for all cities at once in route_passagiere().
 	 * @author Hj. Malthaner
 	 */
 	void step_passagiere();
 
+	/**
+	 * A packet of passengers or mail waiting for its route search
+	 */
+	struct pax_packet_t
+	{
+		stadt_t *city;
+		uint32 route_index;        ///< index of the route search in haltestelle_t::add_prepared_route()
+		uint32 first_start_halt;   ///< start halts are stored in pax_start_halts
+		uint16 start_halt_count;
+		koord origin_pos;
+		koord dest_pos;
+		pax_return_type will_return;
+		fabrik_t *factory;         ///< destination factory, if any
+		sint32 pax_left_to_do;     ///< amount of this packet
+		sint32 num_pax;            ///< amount generated by the building
+	};
+
+	static vector_tpl<pax_packet_t> pax_packets;
+	static vector_tpl<halthandle_t> pax_start_halts;
+
+	/**
+	 * sends a packet on the route found for it
+	 */
+	void book_passagiere(const pax_packet_t &packet);
+
 	/**
 	 * ein Passagierziel in die Zielkarte eintragen
 	 * @author Hj. Malthaner
@@ -524,6 +553,13 @@ public:
 
 	void step(uint32 delta_t);
 
+	/**
+	 * Searches routes for all passengers and mail generated by step() of all cities.
+	 * The searches run in parallel on the unchanged halts, then the packets are
+	 * booked in the order they were generated, so all clients get the same result.
+	 */
+	static void route_passagiere();
+
 	void neuer_monat( bool recalc_destinations );
 
 private:
@@ -54,6 +54,10 @@
 #include "utils/simstring.h"
 #include "utils/cbuffer_t.h"
 
+#ifdef MULTI_THREAD
+#include "utils/simthread.h"
+#endif
+
 
 /*
  * Waiting time for loading (ms)
@@ -158,6 +162,11 @@ void convoi_t::init(player_t *player)
 
 	line_update_pending = linehandle_t();
 
+	planned_step = -1;
+	planned_halt = halthandle_t();
+	planned_pos = koord3d::invalid;
+	planned_vehicles_loading = 0;
+
 	home_depot = koord3d::invalid;
 
 	recalc_data_front = true;
@@ -1139,6 +1148,87 @@ void convoi_t::suche_neue_route()
 }
 
 
+void convoi_t::prepare_route()
+{
+	if(  state != ROUTING_1  ||  wait_lock > 0  ||  anz_vehikel == 0  ||  fpl == NULL  ||  fpl->empty()  ||  line_update_pending.is_bound()  ) {
+		return;
+	}
+	vehicle_t* v = fahr[0];
+	if(  v->get_waytype() == air_wt  ) {
+		// aircrafts change start and target during their search
+		return;
+	}
+	// same target as step() will use
+	const koord3d start = v->get_pos();
+	uint8 index = fpl->get_aktuell();
+	if(  start == fpl->eintrag[index].pos  ) {
+		index = (index+1) % fpl->get_count();
+	}
+	const koord3d ziel = fpl->eintrag[index].pos;
+	if(  start != ziel  ) {
+		route_t::add_prepared_search( v, start, ziel, speed_to_kmh(min_top_speed) );
+	}
+}
+
+
+static const vector_tpl<convoihandle_t> *planned_convois = NULL;
+
+
+void convoi_t::plan_step_job(uint32 i)
+{
+	convoihandle_t cnv = (*planned_convois)[i];
+	cnv->plan_step();
+}
+
+
+#ifdef MULTI_THREAD
+static pthread_mutex_t plan_mutex = PTHREAD_MUTEX_INITIALIZER;
+static uint32 next_planned_convoi = 0;
+
+
+void convoi_t::plan_step_thread(void *, int)
+{
+	// take the next convois in chunks, planning a convoi is often very fast
+	while(true) {
+		pthread_mutex_lock( &plan_mutex );
+		const uint32 first = next_planned_convoi;
+		next_planned_convoi += 16;
+		pthread_mutex_unlock( &plan_mutex );
+		if(  first >= planned_convois->get_count()  ) {
+			break;
+		}
+		const uint32 last = min( first + 16, planned_convois->get_count() );
+		for(  uint32 i = first;  i < last;  i++  ) {
+			plan_step_job( i );
+		}
+	}
+}
+#endif
+
+
+void convoi_t::plan_steps(const vector_tpl<convoihandle_t> &convois)
+{
+	set_random_mode( INTERACTIVE_RANDOM ); // do not allow simrand() here!
+	planned_convois = &convois;
+
+#ifdef MULTI_THREAD
+	if(  env_t::num_threads > 1  &&  convois.get_count() > 16  ) {
+		next_planned_convoi = 0;
+		simthread_run_parallel( plan_step_thread, NULL );
+	}
+	else
+#endif
+	{
+		for(  uint32 i = 0;  i < convois.get_count();  i++  ) {
+			plan_step_job( i );
+		}
+	}
+
+	planned_convois = NULL;
+	clear_random_mode( INTERACTIVE_RANDOM );
+}
+
+
 /**
  * Asynchrne step methode des Convois
  * @author Hj. Malthaner
@@ -2796,15 +2886,9 @@ void convoi_t::calc_gewinn()
 }
 
 
-/**
- * convoi an haltestelle anhalten
- * @author Hj. Malthaner
- *
- * V.Meyer: ladegrad is now stored in the object (not returned)
- */
-void convoi_t::hat_gehalten(halthandle_t halt)
+uint16 convoi_t::calc_vehicles_in_station(halthandle_t halt) const
 {
-	grund_t *gr=welt->lookup(fahr[0]->get_pos());
+	const grund_t *gr=welt->lookup(fahr[0]->get_pos());
 
 	// now find out station length
 	uint16 vehicles_loading = 0;
@@ -2832,7 +2916,7 @@ void convoi_t::hat_gehalten(halthandle_t halt)
 				}
 				else {
 					// all vehicles fit into station
-					goto station_tile_search_ready;
+					return vehicles_loading;
 				}
 			}
 
@@ -2851,9 +2935,47 @@ void convoi_t::hat_gehalten(halthandle_t halt)
 			}
 
 		}  while(  gr  &&  gr->get_halt() == halt  );
-		// finished
-station_tile_search_ready: ;
 	}
+	return vehicles_loading;
+}
+
+
+void convoi_t::plan_step()
+{
+	planned_halt = halthandle_t();
+	if(  state != LOADING  ||  anz_vehikel == 0  ||  fpl == NULL  ) {
+		return;
+	}
+	// same halt as laden() will request the loading from
+	halthandle_t halt = haltestelle_t::get_halt( fpl->get_current_eintrag().pos, owner_p );
+	if(  !halt.is_bound()  ) {
+		return;
+	}
+
+	planned_step = welt->get_steps();
+	planned_pos = fahr[0]->get_pos();
+	planned_vehicles_loading = calc_vehicles_in_station( halt );
+	planned_revenue.clear();
+	for(  uint16 i=0;  i<planned_vehicles_loading;  i++  ) {
+		const vehicle_t* v = fahr[i];
+		planned_revenue.append( v->last_stop_pos != v->get_pos() ? v->calc_revenue( v->last_stop_pos.get_2d(), v->get_pos().get_2d() ) : 0 );
+	}
+	planned_halt = halt;
+}
+
+
+/**
+ * convoi an haltestelle anhalten
+ * @author Hj. Malthaner
+ *
+ * V.Meyer: ladegrad is now stored in the object (not returned)
+ */
+void convoi_t::hat_gehalten(halthandle_t halt)
+{
+	// the plan is only valid, if nothing has moved since
+	const bool planned = planned_halt == halt  &&  planned_step == welt->get_steps()  &&  planned_pos == fahr[0]->get_pos();
+	const uint16 vehicles_loading = planned ? planned_vehicles_loading : calc_vehicles_in_station( halt );
+	planned_halt = halthandle_t();
 
 	// only load vehicles in station
 	// don't load when vehicle is being withdrawn
@@ -2867,7 +2989,7 @@ station_tile_search_ready: ;
 		if(  v->last_stop_pos != v->get_pos()  ) {
 			sint64 tmp;
 			// calc_revenue
-			gewinn += tmp = v->calc_revenue(v->last_stop_pos.get_2d(), v->get_pos().get_2d() );
+			gewinn += tmp = planned ? planned_revenue[i] : v->calc_revenue(v->last_stop_pos.get_2d(), v->get_pos().get_2d() );
 			owner_p->book_revenue(tmp, fahr[0]->get_pos().get_2d(), get_schedule()->get_waytype(), v->get_cargo_type()->get_index());
 			v->last_stop_pos = v->get_pos();
 		}
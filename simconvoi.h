@@ -98,6 +98,17 @@ private:
 	*/
 	linehandle_t line_update_pending;
 
+	/**
+	 * Loading at planned_halt as found by plan_step() for the step planned_step
+	 * while fahr[0] was at planned_pos: the number of vehicles in the station
+	 * and the revenue of each of these vehicles. Used by hat_gehalten() if still valid.
+	 */
+	sint32 planned_step;
+	halthandle_t planned_halt;
+	koord3d planned_pos;
+	uint16 planned_vehicles_loading;
+	vector_tpl<sint64> planned_revenue;
+
 	/**
 	* Name of the convoi.
 	* @see set_name
@@ -397,6 +408,21 @@ private:
 
 	uint32 move_to(uint16 start_index);
 
+	/**
+	 * @return number of vehicles (from the front) which are inside the station @p halt
+	 */
+	uint16 calc_vehicles_in_station(halthandle_t halt) const;
+
+	/**
+	 * Read only part of the next step: precalculates the loading, which is then done by hat_gehalten()
+	 */
+	void plan_step();
+
+	static void plan_step_job(uint32 i);
+#ifdef MULTI_THREAD
+	static void plan_step_thread(void *, int thread_num);
+#endif
+
 public:
 	/**
 	* Convoi haelt an Haltestelle und setzt quote fuer Fracht
@@ -626,6 +652,19 @@ public:
 	*/
 	void suche_neue_route();
 
+	/**
+	 * Queues the route search of the next step, if this convoi will search a route then.
+	 * All queued searches are done together (and in parallel) by route_t::prepare_searches()
+	 */
+	void prepare_route();
+
+	/**
+	 * Plan phase of the convoi steps: does everything of the next step
+	 * of these convois, which only reads the world, at once and in parallel.
+	 * The convois can then do their steps (the commit phase) in any order.
+	 */
+	static void plan_steps(const vector_tpl<convoihandle_t> &convois);
+
 	/**
 	* Wait until vehicle 0 reports free route
 	* will be called during a hop_check, if the road/track is blocked
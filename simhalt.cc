@@ -58,6 +58,9 @@
 
 #include "utils/simrandom.h"
 #include "utils/simstring.h"
+#ifdef MULTI_THREAD
+#include "utils/simthread.h"
+#endif
 
 #include "vehicle/simpeople.h"
 
@@ -74,6 +77,10 @@ inthashtable_tpl<sint32,halthandle_t> *haltestelle_t::all_koords = NULL;
 
 uint8 haltestelle_t::status_step = 0;
 uint8 haltestelle_t::reconnect_counter = 0;
+uint32 haltestelle_t::routing_version = 1;
+
+// no interrupts while halt jobs are running in parallel
+static bool jobs_in_parallel = false;
 
 
 static vector_tpl<convoihandle_t>stale_convois;
@@ -103,7 +110,6 @@ void haltestelle_t::step_all()
 		}
 	}
 
-	static vector_tpl<halthandle_t>::iterator iter( alle_haltestellen.begin() );
 	if (alle_haltestellen.empty()) {
 		return;
 	}
@@ -112,30 +118,25 @@ void haltestelle_t::step_all()
 		// always start with reconnection, re-routing will happen after complete reconnection
 		status_step = RECONNECTING;
 		reconnect_counter = schedule_counter;
-		iter = alle_haltestellen.begin();
-	}
-
-	sint16 units_remaining = 128;
-	for (; iter != alle_haltestellen.end(); ++iter) {
-		if (units_remaining <= 0) return;
-
-		// iterate until the specified number of units were handled
-		if(  !(*iter)->step(status_step, units_remaining)  ) {
-			// too much rerouted => needs to continue at next round!
-			return;
-		}
 	}
 
 	if (status_step == RECONNECTING) {
+		// each halt only reads the schedules and changes its own connections, so all are done at once
+		run_prepared_jobs( reconnect_job, alle_haltestellen.get_count() );
 		// reconnecting finished, compute connected components in one sweep
 		rebuild_connected_components();
-		// reroute in next call
 		status_step = REROUTING;
 	}
-	else if (status_step == REROUTING) {
+
+	if (status_step == REROUTING) {
+		// the route searches only change the goods waiting at their own halt
+		run_prepared_jobs( reroute_job, alle_haltestellen.get_count() );
+		// everything else in a fixed order
+		FOR(vector_tpl<halthandle_t>, const halt, alle_haltestellen) {
+			halt->finish_reroute_goods();
+		}
 		status_step = 0;
 	}
-	iter = alle_haltestellen.begin();
 }
 
 
@@ -337,7 +338,7 @@ haltestelle_t::haltestelle_t(loadsave_t* file)
 {
 	last_loading_step = welt->get_steps();
 
-	waren = (vector_tpl<ware_t> **)calloc( warenbauer_t::get_max_catg_index(), sizeof(vector_tpl<ware_t> *) );
+	waren = (goods_store_t **)calloc( warenbauer_t::get_max_catg_index(), sizeof(goods_store_t *) );
 	all_links = new link_t[ warenbauer_t::get_max_catg_index() ];
 
 	status_color = COL_YELLOW;
@@ -354,7 +355,8 @@ haltestelle_t::haltestelle_t(loadsave_t* file)
 
 	rdwr(file);
 
-	markers[ self.get_id() ] = current_marker;
+	search_context_t &context = get_search_context(0);
+	context.markers[ self.get_id() ] = context.current_marker;
 
 	alle_haltestellen.append(self);
 }
@@ -366,7 +368,8 @@ haltestelle_t::haltestelle_t(koord k, player_t* player_)
 	assert( !alle_haltestellen.is_contained(self) );
 	alle_haltestellen.append(self);
 
-	markers[ self.get_id() ] = current_marker;
+	search_context_t &context = get_search_context(0);
+	context.markers[ self.get_id() ] = context.current_marker;
 
 	last_loading_step = welt->get_steps();
 
@@ -376,9 +379,8 @@ haltestelle_t::haltestelle_t(koord k, player_t* player_)
 	enables = NOT_ENABLED;
 	// force total re-routing
 	reconnect_counter = welt->get_schedule_counter()-1;
-	last_catg_index = 255;
 
-	waren = (vector_tpl<ware_t> **)calloc( warenbauer_t::get_max_catg_index(), sizeof(vector_tpl<ware_t> *) );
+	waren = (goods_store_t **)calloc( warenbauer_t::get_max_catg_index(), sizeof(goods_store_t *) );
 	all_links = new link_t[ warenbauer_t::get_max_catg_index() ];
 
 	status_color = COL_YELLOW;
@@ -443,8 +445,10 @@ haltestelle_t::~haltestelle_t()
 
 	for(unsigned i=0; i<warenbauer_t::get_max_catg_index(); i++) {
 		if (waren[i]) {
-			FOR(vector_tpl<ware_t>, const &w, *waren[i]) {
-				fabrik_t::update_transit(&w, false);
+			FOR(vector_tpl<goods_bucket_t *>, const bucket, waren[i]->get_buckets()) {
+				FOR(vector_tpl<ware_t>, const &w, bucket->waren) {
+					fabrik_t::update_transit(&w, false);
+				}
 			}
 			delete waren[i];
 			waren[i] = NULL;
@@ -464,18 +468,15 @@ void haltestelle_t::rotate90( const sint16 y_size )
 
 	// rotate waren (good) destinations
 	// iterate over all different categories
+	// since the target positions change, the goods must be sorted again
+	vector_tpl<ware_t> warray;
 	for(unsigned i=0; i<warenbauer_t::get_max_catg_index(); i++) {
 		if(waren[i]) {
-			vector_tpl<ware_t>& warray = *waren[i];
-			for (size_t j = warray.get_count(); j-- != 0;) {
-				ware_t& ware = warray[j];
-				if(ware.menge>0) {
-					ware.rotate90(y_size);
-				}
-				else {
-					// empty => remove
-					warray.remove_at(j);
-				}
+			warray.clear();
+			waren[i]->extract(warray);
+			FOR(vector_tpl<ware_t>, & ware, warray) {
+				ware.rotate90(y_size);
+				waren[i]->add(ware);
 			}
 		}
 	}
@@ -875,26 +876,6 @@ void haltestelle_t::request_loading( convoihandle_t cnv )
 
 
 
-bool haltestelle_t::step(uint8 what, sint16 &units_remaining)
-{
-	switch(what) {
-		case RECONNECTING:
-			units_remaining -= (rebuild_connections()/256)+2;
-			break;
-		case REROUTING:
-			if(  !reroute_goods(units_remaining)  ) {
-				return false;
-			}
-			recalc_status();
-			break;
-		default:
-			break;
-	}
-	return true;
-}
-
-
-
 /**
  * Called every month
  * @author Hj. Malthaner
@@ -924,29 +905,30 @@ void haltestelle_t::neuer_monat()
 /**
  * Called after schedule calculation of all stations is finished
  * will distribute the goods to changed routes (if there are any)
- * returns true upon completion
  * @author Hj. Malthaner
  */
-bool haltestelle_t::reroute_goods(sint16 &units_remaining)
+void haltestelle_t::reroute_goods()
 {
-	if(  last_catg_index==255  ) {
-		last_catg_index = 0;
-	}
+	search_reroute_goods( get_search_context(0) );
+	finish_reroute_goods();
+}
 
-	for(  ; last_catg_index<warenbauer_t::get_max_catg_index(); last_catg_index++) {
 
-		if(  units_remaining<=0  ) {
-			return false;
-		}
+void haltestelle_t::search_reroute_goods(search_context_t &context)
+{
+	// the search history may be from an earlier rerouting
+	context.last_search_origin = halthandle_t();
 
-		if(waren[last_catg_index]) {
+	vector_tpl<ware_t> warray;
+	for(  uint8 catg_index = 0;  catg_index<warenbauer_t::get_max_catg_index();  catg_index++  ) {
 
-			// first: clean out the array
-			vector_tpl<ware_t> * warray = waren[last_catg_index];
-			vector_tpl<ware_t> * new_warray = new vector_tpl<ware_t>(warray->get_count());
+		if(waren[catg_index]) {
 
-			for (size_t j = warray->get_count(); j-- != 0;) {
-				ware_t & ware = (*warray)[j];
+			// take out all goods, they will be sorted in again by their new next transfer stop
+			warray.clear();
+			waren[catg_index]->extract(warray);
+
+			FOR(vector_tpl<ware_t>, & ware, warray) {
 
 				if(ware.menge==0) {
 					continue;
@@ -956,54 +938,49 @@ bool haltestelle_t::reroute_goods(sint16 &units_remaining)
 				if(  welt->access(ware.get_zielpos())->is_connected(self)  ) {
 					// we are already there!
 					if(  ware.to_factory  ) {
-						liefere_an_fabrik(ware);
+						rerouted_arrived.append( ware );
 					}
 					continue;
 				}
 
-				// add to new array
-				new_warray->append( ware );
+				// re-route goods to adapt to changes in world layout,
+				// remove all goods whose destination was removed from the map
+				search_route_resumable(context, ware);
+				if(  ware.get_ziel()==halthandle_t()  ) {
+					// remove invalid destinations
+					rerouted_lost.append( ware );
+					continue;
+				}
+
+				if(  !waren[catg_index]->join(ware, true)  ) {
+					waren[catg_index]->add(ware);
+				}
 			}
 
 			// delete, if nothing connects here
-			if(  new_warray->empty()  ) {
-				if(  all_links[last_catg_index].connections.empty()  ) {
-					// no connections from here => delete
-					delete new_warray;
-					new_warray = NULL;
-				}
-			}
-
-			// replace the array
-			delete waren[last_catg_index];
-			waren[last_catg_index] = new_warray;
-
-			// if something left
-			// re-route goods to adapt to changes in world layout,
-			// remove all goods whose destination was removed from the map
-			if (waren[last_catg_index] && !waren[last_catg_index]->empty()) {
-
-				vector_tpl<ware_t> &warray = *waren[last_catg_index];
-				uint32 last_ware_index = 0;
-				units_remaining -= warray.get_count();
-				while(  last_ware_index<warray.get_count()  ) {
-					search_route_resumable(warray[last_ware_index]);
-					if(  warray[last_ware_index].get_ziel()==halthandle_t()  ) {
-						// remove invalid destinations
-						fabrik_t::update_transit( &warray[last_ware_index], false);
-						warray.remove_at(last_ware_index);
-					}
-					else {
-						++last_ware_index;
-					}
-				}
+			if(  waren[catg_index]->empty()  &&  all_links[catg_index].connections.empty()  ) {
+				// no connections from here => delete
+				delete waren[catg_index];
+				waren[catg_index] = NULL;
 			}
 		}
 	}
 	// likely the display must be updated after this
 	resort_freight_info = true;
-	last_catg_index = 255;	// all categories are rerouted
-	return true;	// all updated ...
+}
+
+
+void haltestelle_t::finish_reroute_goods()
+{
+	FOR(vector_tpl<ware_t>, const& ware, rerouted_arrived) {
+		liefere_an_fabrik(ware);
+	}
+	rerouted_arrived.clear();
+	FOR(vector_tpl<ware_t>, const& ware, rerouted_lost) {
+		fabrik_t::update_transit( &ware, false );
+	}
+	rerouted_lost.clear();
+	recalc_status();
 }
 
 
@@ -1058,25 +1035,41 @@ void haltestelle_t::remove_fabriken(fabrik_t *fab)
 // the minimum weight of a connection from a transfer halt
 #define WEIGHT_MIN (WEIGHT_WAIT+WEIGHT_HALT)
 sint32 haltestelle_t::rebuild_connections()
+{
+	return rebuild_connections( get_search_context(0) );
+}
+
+
+sint32 haltestelle_t::rebuild_connections(search_context_t &context)
 {
 	// Knightly : halts which either immediately precede or succeed self halt in serving schedules
-	static vector_tpl<halthandle_t> consecutive_halts[256];
+	vector_tpl<halthandle_t> *const consecutive_halts = context.consecutive_halts;
 	// Dwachs : halts which either immediately precede or succeed self halt in currently processed schedule
-	static vector_tpl<halthandle_t> consecutive_halts_fpl[256];
+	vector_tpl<halthandle_t> *const consecutive_halts_fpl = context.consecutive_halts_fpl;
 	// remember max number of consecutive halts for one schedule
 	uint8 max_consecutive_halts_fpl[256];
 	MEMZERON(max_consecutive_halts_fpl, warenbauer_t::get_max_catg_index());
 	// Knightly : previous halt supporting the ware categories of the serving line
-	static halthandle_t previous_halt[256];
+	halthandle_t *const previous_halt = context.previous_halt;
+
+	// remember the old connections to find out, whether the routing tables are still valid
+	const bool track_changes = welt->get_settings().is_halt_routing_table();
+	vector_tpl<connection_t> *const old_connections = context.old_connections;
+	bool old_is_transfer[256];
+	uint16 old_component[256];
 
 	// Hajo: first, remove all old entries
 	for(  uint8 i=0;  i<warenbauer_t::get_max_catg_index();  i++  ){
+		if(  track_changes  ) {
+			swap( old_connections[i], all_links[i].connections );
+			old_is_transfer[i] = all_links[i].is_transfer;
+			old_component[i] = all_links[i].catg_connected_component;
+		}
 		all_links[i].clear();
 		consecutive_halts[i].clear();
 	}
 	resort_freight_info = true;	// might result in error in routing
 
-	last_catg_index = 255;	// must reroute everything
 	sint32 connections_searched = 0;
 
 // DBG_MESSAGE("haltestelle_t::rebuild_destinations()", "Adding new table entries");
@@ -1144,7 +1137,9 @@ sint32 haltestelle_t::rebuild_connections()
 			continue;
 		}
 
-		INT_CHECK("simhalt.cc 612");
+		if(  !jobs_in_parallel  ) {
+			INT_CHECK("simhalt.cc 612");
+		}
 
 		// now we add the schedule to the connection array
 		uint16 aggregate_weight = WEIGHT_WAIT;
@@ -1205,6 +1200,18 @@ sint32 haltestelle_t::rebuild_connections()
 				all_links[i].is_transfer = true;
 			}
 		}
+
+		if(  track_changes  &&  !all_links[i].routing_changed  ) {
+			const vector_tpl<connection_t> &connections = all_links[i].connections;
+			bool changed = old_is_transfer[i] != all_links[i].is_transfer  ||  old_connections[i].get_count() != connections.get_count();
+			for(  uint32 j=0;  !changed  &&  j<connections.get_count();  j++  ) {
+				changed = old_connections[i][j].halt != connections[j].halt  ||  old_connections[i][j].weight != connections[j].weight;
+			}
+			if(  changed  ) {
+				all_links[i].routing_changed = true;
+				all_links[i].routing_changed_component = old_component[i];
+			}
+		}
 	}
 	return connections_searched;
 }
@@ -1226,16 +1233,18 @@ void haltestelle_t::rebuild_linked_connections()
 }
 
 
-void haltestelle_t::fill_connected_component(uint8 catg_idx, uint16 comp)
+void haltestelle_t::fill_connected_component(uint8 catg_idx, uint16 comp, vector_tpl<halthandle_t> &component_halts)
 {
 	if (all_links[catg_idx].catg_connected_component != UNDECIDED_CONNECTED_COMPONENT) {
 		// already connected
 		return;
 	}
 	all_links[catg_idx].catg_connected_component = comp;
+	all_links[catg_idx].catg_component_index = component_halts.get_count();
+	component_halts.append(self);
 
 	FOR(vector_tpl<connection_t>, &c, all_links[catg_idx].connections) {
-		c.halt->fill_connected_component(catg_idx, comp);
+		c.halt->fill_connected_component(catg_idx, comp, component_halts);
 		// cache the is_transfer value
 		c.is_transfer = c.halt->is_transfer(catg_idx);
 	}
@@ -1244,14 +1253,22 @@ void haltestelle_t::fill_connected_component(uint8 catg_idx, uint16 comp)
 
 void haltestelle_t::rebuild_connected_components()
 {
+	static vector_tpl<halthandle_t> component_halts;
 	for(uint8 catg_idx = 0; catg_idx<warenbauer_t::get_max_catg_index(); catg_idx++) {
 		FOR(vector_tpl<halthandle_t>, halt, alle_haltestellen) {
 			if (halt->all_links[catg_idx].catg_connected_component == UNDECIDED_CONNECTED_COMPONENT) {
 				// start recursion
-				halt->fill_connected_component(catg_idx, halt.get_id());
+				component_halts.clear();
+				halt->fill_connected_component(catg_idx, halt.get_id(), component_halts);
+				FOR(vector_tpl<halthandle_t>, const h, component_halts) {
+					h->all_links[catg_idx].catg_component_size = component_halts.get_count();
+				}
 			}
 		}
 	}
+	// routes in changed components must be searched again
+	invalidate_routing_tables();
+	routing_version++;
 }
 
 
@@ -1276,15 +1293,15 @@ sint8 haltestelle_t::is_connected(halthandle_t halt, uint8 catg_index) const
 /**
  * Data for route searching
  */
-haltestelle_t::halt_data_t haltestelle_t::halt_data[65536];
-binary_heap_tpl<haltestelle_t::route_node_t> haltestelle_t::open_list;
-uint8 haltestelle_t::markers[65536];
-uint8 haltestelle_t::current_marker = 0;
-/**
- * Data for resumable route search
- */
-halthandle_t haltestelle_t::last_search_origin;
-uint8 haltestelle_t::last_search_ware_catg_idx = 255;
+haltestelle_t::search_context_t *haltestelle_t::search_contexts[MAX_THREADS];
+
+haltestelle_t::search_context_t &haltestelle_t::get_search_context(uint32 i)
+{
+	if(  search_contexts[i] == NULL  ) {
+		search_contexts[i] = new search_context_t();
+	}
+	return *search_contexts[i];
+}
 /**
  * This routine tries to find a route for a good packet (ware)
  * it will be called for
@@ -1306,17 +1323,28 @@ uint8 haltestelle_t::last_search_ware_catg_idx = 255;
  */
 int haltestelle_t::search_route( const halthandle_t *const start_halts, const uint16 start_halt_count, const bool no_routing_over_overcrowding, ware_t &ware, ware_t *const return_ware )
 {
+	return search_route( get_search_context(0), start_halts, start_halt_count, no_routing_over_overcrowding, ware, return_ware );
+}
+
+
+int haltestelle_t::search_route( search_context_t &context, const halthandle_t *const start_halts, const uint16 start_halt_count, const bool no_routing_over_overcrowding, ware_t &ware, ware_t *const return_ware )
+{
+	halt_data_t *const halt_data = context.halt_data;
+	binary_heap_tpl<route_node_t> &open_list = context.open_list;
+	uint8 *const markers = context.markers;
+	uint8 &current_marker = context.current_marker;
+
 	const uint8 ware_catg_idx = ware.get_besch()->get_catg_index();
 
 	// since also the factory halt list is added to the ground, we can use just this ...
 	const planquadrat_t *const plan = welt->access( ware.get_zielpos() );
 	const halthandle_t *const halt_list = plan->get_haltlist();
 	// but we can only use a subset of these
-	static vector_tpl<halthandle_t> end_halts(16);
+	vector_tpl<halthandle_t> &end_halts = context.end_halts;
 	end_halts.clear();
 	// target halts are in these connected components
 	// we start from halts only in the same components
-	static vector_tpl<uint16> end_conn_comp(16);
+	vector_tpl<uint16> &end_conn_comp = context.end_conn_comp;
 	end_conn_comp.clear();
 	// if one target halt is undefined, we have to start search from all halts
 	bool end_conn_comp_undefined = false;
@@ -1364,8 +1392,13 @@ int haltestelle_t::search_route( const halthandle_t *const start_halts, const ui
 		}
 		return NO_ROUTE;
 	}
+
+	if(  use_routing_table( no_routing_over_overcrowding )  ) {
+		return search_route_table( context, start_halts, start_halt_count, end_halts, ware, return_ware );
+	}
+
 	// invalidate search history
-	last_search_origin = halthandle_t();
+	context.last_search_origin = halthandle_t();
 
 	// set current marker
 	++current_marker;
@@ -1570,9 +1603,54 @@ int haltestelle_t::search_route( const halthandle_t *const start_halts, const ui
 
 void haltestelle_t::search_route_resumable(  ware_t &ware   )
 {
+	search_route_resumable( get_search_context(0), ware );
+}
+
+
+void haltestelle_t::search_route_resumable( search_context_t &context, ware_t &ware )
+{
+	halt_data_t *const halt_data = context.halt_data;
+	binary_heap_tpl<route_node_t> &open_list = context.open_list;
+	uint8 *const markers = context.markers;
+	uint8 &current_marker = context.current_marker;
+
 	const uint8 ware_catg_idx = ware.get_besch()->get_catg_index();
 
+	if(  use_routing_table( false )  ) {
+		// just look up the best destination halt; this does not touch the search history
+		ware.set_ziel( halthandle_t() );
+		ware.set_zwischenziel( halthandle_t() );
+		const bool connected = all_links[ware_catg_idx].catg_connected_component != UNDECIDED_CONNECTED_COMPONENT;
+		const routing_row_t *const row = connected ? get_routing_row( context, ware_catg_idx ) : NULL;
+		const planquadrat_t *const plan = welt->access( ware.get_zielpos() );
+		const halthandle_t *const halt_list = plan->get_haltlist();
+		uint16 best_destination_weight = 65535u;
+		for(  uint8 h=0;  h<plan->get_haltlist_count();  ++h  ) {
+			const halthandle_t halt = halt_list[h];
+			if(  halt == self  ) {
+				// a destination halt is the same as the current halt -> no route searching is necessary
+				ware.set_ziel( self );
+				ware.set_zwischenziel( halthandle_t() );
+				return;
+			}
+			if(  row  &&  halt.is_bound()  &&  halt->is_enabled(ware_catg_idx)  ) {
+				const link_t &dest_link = halt->all_links[ware_catg_idx];
+				if(  dest_link.catg_connected_component == row->component  ) {
+					const routing_entry_t &entry = row->entries[ dest_link.catg_component_index ];
+					if(  entry.weight < best_destination_weight  ) {
+						best_destination_weight = entry.weight;
+						ware.set_ziel( halt );
+						ware.set_zwischenziel( entry.first_hop );
+					}
+				}
+			}
+		}
+		return;
+	}
+
 	// continue search if start halt and good category did not change
+	halthandle_t &last_search_origin = context.last_search_origin;
+	uint8 &last_search_ware_catg_idx = context.last_search_ware_catg_idx;
 	const bool resume_search = last_search_origin == self  &&  ware_catg_idx == last_search_ware_catg_idx;
 
 	if (!resume_search) {
@@ -1588,7 +1666,7 @@ void haltestelle_t::search_route_resumable(  ware_t &ware   )
 	}
 
 	// remember destination nodes, to reset them before returning
-	static vector_tpl<uint16> dest_indices(16);
+	vector_tpl<uint16> &dest_indices = context.dest_indices;
 	dest_indices.clear();
 
 	uint16 best_destination_weight = 65535u;
@@ -1666,7 +1744,7 @@ void haltestelle_t::search_route_resumable(  ware_t &ware   )
 	uint16 const max_transfers = welt->get_settings().get_max_transfers();
 	uint16 const max_hops      = welt->get_settings().get_max_hops();
 
-	static uint16 allocation_pointer;
+	uint16 &allocation_pointer = context.allocation_pointer;
 	if (!resume_search) {
 		// initialise the origin node
 		allocation_pointer = 1u;
@@ -1784,6 +1862,351 @@ void haltestelle_t::search_route_resumable(  ware_t &ware   )
 }
 
 
+bool haltestelle_t::use_routing_table( const bool no_routing_over_overcrowding )
+{
+	return  welt->get_settings().is_halt_routing_table()  &&  !no_routing_over_overcrowding
+		&&  status_step != RECONNECTING  &&  reconnect_counter == welt->get_schedule_counter();
+}
+
+
+bool haltestelle_t::is_routing_row_valid( const uint8 catg ) const
+{
+	const link_t &link = all_links[catg];
+	const routing_row_t *const row = link.routing_row;
+	return  row != NULL  &&  row->component == link.catg_connected_component  &&  row->count == link.catg_component_size
+		&&  row->max_transfers == welt->get_settings().get_max_transfers();
+}
+
+
+void haltestelle_t::alloc_routing_row( const uint8 catg )
+{
+	link_t &link = all_links[catg];
+	assert( link.catg_connected_component != UNDECIDED_CONNECTED_COMPONENT  &&  link.catg_component_size > 0 );
+	if(  link.routing_row == NULL  ) {
+		link.routing_row = new routing_row_t();
+	}
+	routing_row_t *const row = link.routing_row;
+	if(  row->count != link.catg_component_size  ) {
+		delete [] row->entries;
+		row->count = link.catg_component_size;
+		row->entries = new routing_entry_t[ row->count ];
+	}
+	row->component = link.catg_connected_component;
+	row->max_transfers = welt->get_settings().get_max_transfers();
+}
+
+
+void haltestelle_t::fill_routing_row( search_context_t &context, const uint8 catg )
+{
+	// invalidate search history
+	context.last_search_origin = halthandle_t();
+	halt_data_t *const halt_data = context.halt_data;
+	binary_heap_tpl<route_node_t> &open_list = context.open_list;
+
+	routing_row_t *const row = all_links[catg].routing_row;
+	routing_entry_t *const entries = row->entries;
+	for(  uint16 i=0;  i<row->count;  i++  ) {
+		entries[i].weight = 65535u;
+		entries[i].first_hop = halthandle_t();
+		entries[i].previous = halthandle_t();
+	}
+
+	// like search_route(), only transfer halts are passed through, but all halts get their best weight
+	open_list.clear();
+	entries[ all_links[catg].catg_component_index ].weight = 0;
+	halt_data[ self.get_id() ].depth = 0;
+	open_list.insert( route_node_t(self, 0) );
+
+	while(  !open_list.empty()  ) {
+		route_node_t current_node = open_list.pop();
+		const link_t &current_link = current_node.halt->all_links[catg];
+		const routing_entry_t &current = entries[ current_link.catg_component_index ];
+		if(  current_node.aggregate_weight > current.weight  ) {
+			// shortest path to the current halt has already been found earlier
+			continue;
+		}
+
+		const uint16 depth = halt_data[ current_node.halt.get_id() ].depth;
+		if(  depth > row->max_transfers  ) {
+			// maximum transfer limit is reached
+			continue;
+		}
+
+		FOR(vector_tpl<connection_t>, const& current_conn, current_link.connections) {
+			if(  !current_conn.halt.is_bound()  ) {
+				continue;
+			}
+			const link_t &reachable_link = current_conn.halt->all_links[catg];
+			if(  reachable_link.catg_connected_component != row->component  ) {
+				// must not happen once the connected components are complete
+				continue;
+			}
+			routing_entry_t &reachable = entries[ reachable_link.catg_component_index ];
+			const uint32 total_weight = (uint32)current.weight + current_conn.weight;
+			if(  total_weight < reachable.weight  ) {
+				reachable.weight = total_weight;
+				reachable.first_hop = current_node.halt == self ? current_conn.halt : current.first_hop;
+				reachable.previous = current_node.halt;
+				halt_data[ current_conn.halt.get_id() ].depth = depth + 1u;
+				if(  current_conn.is_transfer  ) {
+					open_list.insert( route_node_t(current_conn.halt, total_weight) );
+				}
+			}
+		}
+	}
+}
+
+
+const haltestelle_t::routing_row_t *haltestelle_t::get_routing_row( search_context_t &context, const uint8 catg )
+{
+	if(  !is_routing_row_valid(catg)  ) {
+		alloc_routing_row( catg );
+		fill_routing_row( context, catg );
+	}
+	return all_links[catg].routing_row;
+}
+
+
+int haltestelle_t::search_route_table( search_context_t &context, const halthandle_t *const start_halts, const uint16 start_halt_count, const vector_tpl<halthandle_t> &end_halts, ware_t &ware, ware_t *const return_ware )
+{
+	const uint8 ware_catg_idx = ware.get_besch()->get_catg_index();
+
+	uint16 best_weight = 65535u;
+	halthandle_t best_start, best_end;
+	const routing_entry_t *best_entry = NULL;
+	for(  uint16 s=0;  s<start_halt_count;  ++s  ) {
+		const halthandle_t start_halt = start_halts[s];
+		if(  start_halt->all_links[ware_catg_idx].catg_connected_component == UNDECIDED_CONNECTED_COMPONENT  ) {
+			continue;
+		}
+		const routing_row_t *const row = start_halt->get_routing_row( context, ware_catg_idx );
+		FOR(vector_tpl<halthandle_t>, const e, end_halts) {
+			const link_t &end_link = e->all_links[ware_catg_idx];
+			if(  end_link.catg_connected_component != row->component  ) {
+				continue;
+			}
+			const routing_entry_t &entry = row->entries[ end_link.catg_component_index ];
+			if(  entry.weight < best_weight  ) {
+				best_weight = entry.weight;
+				best_start = start_halt;
+				best_end = e;
+				best_entry = &entry;
+			}
+		}
+	}
+
+	if(  best_entry == NULL  ) {
+		ware.set_ziel( halthandle_t() );
+		ware.set_zwischenziel( halthandle_t() );
+		if(  return_ware  ) {
+			return_ware->set_ziel( halthandle_t() );
+			return_ware->set_zwischenziel( halthandle_t() );
+		}
+		return NO_ROUTE;
+	}
+
+	ware.set_ziel( best_end );
+	ware.set_zwischenziel( best_entry->first_hop );
+	if(  return_ware  ) {
+		// same as in search_route(): the previous halt is only certain to be the next transfer,
+		// if the end halt and its connections contain at most one transfer halt
+		uint8 t = best_end->is_transfer(ware_catg_idx);
+		FOR(vector_tpl<connection_t>, const& i, best_end->all_links[ware_catg_idx].connections) {
+			if (t > 1) {
+				break;
+			}
+			t += i.halt.is_bound() && i.is_transfer;
+		}
+		return_ware->set_zwischenziel(  t<=1  ?  best_entry->previous  : halthandle_t());
+		return_ware->set_ziel( best_start );
+	}
+	return ROUTE_OK;
+}
+
+
+void haltestelle_t::invalidate_routing_tables()
+{
+	if(  !welt->get_settings().is_halt_routing_table()  ) {
+		return;
+	}
+	// one bit per component id
+	static uint8 dirty[65536/8];
+	for(  uint8 catg_idx = 0;  catg_idx<warenbauer_t::get_max_catg_index();  catg_idx++  ) {
+		MEMZERO(dirty);
+		FOR(vector_tpl<halthandle_t>, const halt, alle_haltestellen) {
+			link_t &link = halt->all_links[catg_idx];
+			if(  link.routing_changed  ) {
+				// routes in the old and the new component may have used this halt
+				const uint16 old_comp = link.routing_changed_component;
+				const uint16 new_comp = link.catg_connected_component;
+				dirty[old_comp/8] |= 1 << (old_comp%8);
+				dirty[new_comp/8] |= 1 << (new_comp%8);
+				link.routing_changed = false;
+			}
+		}
+		FOR(vector_tpl<halthandle_t>, const halt, alle_haltestellen) {
+			link_t &link = halt->all_links[catg_idx];
+			if(  link.routing_row  ) {
+				const uint16 comp = link.routing_row->component;
+				if(  (dirty[comp/8] & (1 << (comp%8)))  ||  comp != link.catg_connected_component  ) {
+					delete link.routing_row;
+					link.routing_row = NULL;
+				}
+			}
+		}
+	}
+}
+
+
+vector_tpl<haltestelle_t::prepared_route_t> haltestelle_t::prepared_routes;
+vector_tpl<halthandle_t> haltestelle_t::prepared_start_halts;
+
+
+uint32 haltestelle_t::add_prepared_route( const halthandle_t *const start_halts, const uint16 start_halt_count, const bool no_routing_over_overcrowding, const ware_t &ware, const ware_t &return_ware )
+{
+	prepared_route_t route;
+	route.first_start_halt = prepared_start_halts.get_count();
+	route.start_halt_count = start_halt_count;
+	route.no_routing_over_overcrowding = no_routing_over_overcrowding;
+	route.ware = ware;
+	route.return_ware = return_ware;
+	route.result = NO_ROUTE;
+	for(  uint16 s=0;  s<start_halt_count;  s++  ) {
+		prepared_start_halts.append( start_halts[s] );
+	}
+	prepared_routes.append( route );
+	return prepared_routes.get_count()-1;
+}
+
+
+vector_tpl<haltestelle_t::prepared_row_t> haltestelle_t::prepared_rows;
+haltestelle_t::prepared_job_t haltestelle_t::prepared_job = NULL;
+
+
+void haltestelle_t::prepared_route_job( search_context_t &context, uint32 i )
+{
+	prepared_route_t &route = prepared_routes[i];
+	route.result = search_route( context, &prepared_start_halts[route.first_start_halt], route.start_halt_count, route.no_routing_over_overcrowding, route.ware, &route.return_ware );
+}
+
+
+void haltestelle_t::prepared_row_job( search_context_t &context, uint32 i )
+{
+	prepared_rows[i].halt->fill_routing_row( context, prepared_rows[i].catg );
+}
+
+
+void haltestelle_t::reconnect_job( search_context_t &context, uint32 i )
+{
+	alle_haltestellen[i]->rebuild_connections( context );
+}
+
+
+void haltestelle_t::reroute_job( search_context_t &context, uint32 i )
+{
+	alle_haltestellen[i]->search_reroute_goods( context );
+}
+
+
+#ifdef MULTI_THREAD
+static pthread_mutex_t prepared_route_mutex = PTHREAD_MUTEX_INITIALIZER;
+static uint32 next_prepared_job = 0;
+static uint32 prepared_job_count = 0;
+
+
+void haltestelle_t::prepared_route_thread(void *, int thread_num)
+{
+	search_context_t &context = *search_contexts[thread_num];
+
+	// take the next job until all are done; each job only writes to its own context and result
+	while(true) {
+		pthread_mutex_lock( &prepared_route_mutex );
+		const uint32 i = next_prepared_job++;
+		pthread_mutex_unlock( &prepared_route_mutex );
+		if(  i >= prepared_job_count  ) {
+			break;
+		}
+		prepared_job( context, i );
+	}
+}
+#endif
+
+
+void haltestelle_t::run_prepared_jobs( prepared_job_t job, uint32 count )
+{
+	set_random_mode( INTERACTIVE_RANDOM ); // do not allow simrand() here!
+#ifdef MULTI_THREAD
+	if(  env_t::num_threads > 1  &&  count > 1  ) {
+		// all contexts must exist before the threads start
+		for(  int t = 0;  t < env_t::num_threads;  t++  ) {
+			get_search_context(t);
+		}
+		prepared_job = job;
+		prepared_job_count = count;
+		next_prepared_job = 0;
+		jobs_in_parallel = true;
+		simthread_run_parallel( prepared_route_thread, NULL );
+		jobs_in_parallel = false;
+	}
+	else
+#endif
+	{
+		search_context_t &context = get_search_context(0);
+		for(  uint32 i=0;  i<count;  i++  ) {
+			job( context, i );
+		}
+	}
+	clear_random_mode( INTERACTIVE_RANDOM );
+}
+
+
+void haltestelle_t::prepare_routes()
+{
+	if(  prepared_routes.empty()  ) {
+		return;
+	}
+
+	// the routing rows of all start halts must be ready, since they cannot be built during the parallel searches
+	prepared_rows.clear();
+	FOR(vector_tpl<prepared_route_t>, const& route, prepared_routes) {
+		if(  use_routing_table( route.no_routing_over_overcrowding )  ) {
+			const uint8 catg = route.ware.get_besch()->get_catg_index();
+			for(  uint16 s=0;  s<route.start_halt_count;  s++  ) {
+				halthandle_t const halt = prepared_start_halts[route.first_start_halt+s];
+				if(  halt->all_links[catg].catg_connected_component != UNDECIDED_CONNECTED_COMPONENT  &&  !halt->is_routing_row_valid(catg)  ) {
+					// now it counts as valid, so it is added only once
+					halt->alloc_routing_row(catg);
+					prepared_row_t row;
+					row.halt = halt;
+					row.catg = catg;
+					prepared_rows.append( row );
+				}
+			}
+		}
+	}
+	run_prepared_jobs( prepared_row_job, prepared_rows.get_count() );
+	prepared_rows.clear();
+
+	run_prepared_jobs( prepared_route_job, prepared_routes.get_count() );
+}
+
+
+int haltestelle_t::get_prepared_route( uint32 i, ware_t &ware, ware_t &return_ware )
+{
+	const prepared_route_t &route = prepared_routes[i];
+	ware = route.ware;
+	return_ware = route.return_ware;
+	return route.result;
+}
+
+
+void haltestelle_t::clear_prepared_routes()
+{
+	prepared_routes.clear();
+	prepared_start_halts.clear();
+}
+
+
 /**
  * Found route and station uncrowded
  * @author Hj. Malthaner
@@ -1836,31 +2259,222 @@ void haltestelle_t::liefere_an_fabrik(const ware_t& ware) const
 }
 
 
+uint32 haltestelle_t::goods_bucket_t::lower_bound(uint64 key) const
+{
+	uint32 low = 0, high = waren.get_count();
+	while(  low < high  ) {
+		const uint32 mid = (low + high) >> 1;
+		if(  goods_store_t::get_destination_key( waren[mid] ) < key  ) {
+			low = mid + 1;
+		}
+		else {
+			high = mid;
+		}
+	}
+	return low;
+}
+
+
+haltestelle_t::goods_store_t::~goods_store_t()
+{
+	FOR(vector_tpl<goods_bucket_t *>, const bucket, buckets) {
+		delete bucket;
+	}
+}
+
+
+uint64 haltestelle_t::goods_store_t::get_factory_key(uint8 index, koord zielpos)
+{
+	return ((uint64)index << 48) | ((uint64)(uint16)zielpos.x << 32) | ((uint64)(uint16)zielpos.y << 16);
+}
+
+
+uint64 haltestelle_t::goods_store_t::get_destination_key(const ware_t &ware)
+{
+	// goods not for factories join regardless of their target position
+	const uint64 key = ware.to_factory ? get_factory_key( ware.get_index(), ware.get_zielpos() ) : ((uint64)ware.get_index() << 48) | ((uint64)0xFFFFFFFFu << 16);
+	return key | ware.get_ziel().get_id();
+}
+
+
+haltestelle_t::goods_bucket_t *haltestelle_t::goods_store_t::get_bucket(halthandle_t zwischenziel) const
+{
+	FOR(vector_tpl<goods_bucket_t *>, const bucket, buckets) {
+		if(  bucket->zwischenziel == zwischenziel  ) {
+			return bucket;
+		}
+	}
+	return NULL;
+}
+
+
+bool haltestelle_t::goods_store_t::empty() const
+{
+	FOR(vector_tpl<goods_bucket_t *>, const bucket, buckets) {
+		if(  !bucket->waren.empty()  ) {
+			return false;
+		}
+	}
+	return true;
+}
+
+
+void haltestelle_t::goods_store_t::book_summe(const ware_t &ware, sint32 delta)
+{
+	while(  summe.get_count() <= ware.get_index()  ) {
+		summe.append( 0 );
+	}
+	summe[ware.get_index()] += delta;
+}
+
+
+void haltestelle_t::goods_store_t::insert(const ware_t &ware)
+{
+	goods_bucket_t *bucket = get_bucket( ware.get_zwischenziel() );
+	if(  bucket == NULL  ) {
+		bucket = new goods_bucket_t( ware.get_zwischenziel() );
+		buckets.append( bucket );
+	}
+	bucket->waren.insert_at( bucket->lower_bound( get_destination_key(ware) ), ware );
+}
+
+
+void haltestelle_t::goods_store_t::add(const ware_t &ware)
+{
+	insert( ware );
+	book_summe( ware, ware.menge );
+}
+
+
+bool haltestelle_t::goods_store_t::join(const ware_t &ware, bool update_route)
+{
+	const uint64 key = get_destination_key(ware);
+
+	// most likely the packet waits already for the same next stop
+	goods_bucket_t *target = update_route ? get_bucket( ware.get_zwischenziel() ) : NULL;
+	if(  target  ) {
+		const uint32 i = target->lower_bound(key);
+		if(  i < target->waren.get_count()  &&  get_destination_key( target->waren[i] ) == key  ) {
+			target->waren[i].menge += ware.menge;
+			book_summe( ware, ware.menge );
+			return true;
+		}
+	}
+
+	FOR(vector_tpl<goods_bucket_t *>, const bucket, buckets) {
+		if(  bucket == target  ) {
+			continue;
+		}
+		const uint32 i = bucket->lower_bound(key);
+		if(  i < bucket->waren.get_count()  &&  get_destination_key( bucket->waren[i] ) == key  ) {
+			if(  update_route  ) {
+				// there is a newer route => move to the bucket of the new next stop
+				ware_t tmp = bucket->waren[i];
+				bucket->waren.remove_at(i);
+				free_if_empty( bucket );
+				tmp.menge += ware.menge;
+				tmp.set_zwischenziel( ware.get_zwischenziel() );
+				insert( tmp );
+			}
+			else {
+				bucket->waren[i].menge += ware.menge;
+			}
+			book_summe( ware, ware.menge );
+			return true;
+		}
+	}
+	return false;
+}
+
+
+void haltestelle_t::goods_store_t::take(goods_bucket_t *bucket, uint32 index, uint32 menge, ware_t &ware)
+{
+	ware_t &tmp = bucket->waren[index];
+	ware = tmp;
+	if(  tmp.menge > menge  ) {
+		// not all can be taken
+		ware.menge = menge;
+		tmp.menge -= menge;
+	}
+	else {
+		tmp.menge = 0;
+	}
+	book_summe( ware, -(sint32)ware.menge );
+}
+
+
+void haltestelle_t::goods_store_t::compact(goods_bucket_t *bucket)
+{
+	for(  uint32 i = bucket->waren.get_count();  i-- > 0;  ) {
+		if(  bucket->waren[i].menge == 0  ) {
+			bucket->waren.remove_at(i);
+		}
+	}
+	free_if_empty( bucket );
+}
+
+
+void haltestelle_t::goods_store_t::free_if_empty(goods_bucket_t *bucket)
+{
+	if(  bucket->waren.empty()  ) {
+		buckets.remove( bucket );
+		delete bucket;
+	}
+}
+
+
+void haltestelle_t::goods_store_t::collect(vector_tpl<ware_t> &list) const
+{
+	FOR(vector_tpl<goods_bucket_t *>, const bucket, buckets) {
+		FOR(vector_tpl<ware_t>, const& ware, bucket->waren) {
+			list.append( ware );
+		}
+	}
+}
+
+
+void haltestelle_t::goods_store_t::extract(vector_tpl<ware_t> &list)
+{
+	collect( list );
+	FOR(vector_tpl<goods_bucket_t *>, const bucket, buckets) {
+		delete bucket;
+	}
+	buckets.clear();
+	summe.clear();
+}
+
+
+uint32 haltestelle_t::goods_store_t::get_summe(uint8 index, koord zielpos) const
+{
+	// all goods for this factory follow each other, only the target halt differs
+	const uint64 key = get_factory_key( index, zielpos );
+	uint32 sum = 0;
+	FOR(vector_tpl<goods_bucket_t *>, const bucket, buckets) {
+		for(  uint32 i = bucket->lower_bound(key);  i < bucket->waren.get_count()  &&  (get_destination_key( bucket->waren[i] ) >> 16) == (key >> 16);  i++  ) {
+			sum += bucket->waren[i].menge;
+		}
+	}
+	return sum;
+}
+
+
 /* retrieves a ware packet for any destination in the list
  * needed, if the factory in question wants to remove something
  */
 bool haltestelle_t::recall_ware( ware_t& w, uint32 menge )
 {
 	w.menge = 0;
-	vector_tpl<ware_t> *warray = waren[w.get_besch()->get_catg_index()];
-	if(warray!=NULL) {
-		FOR(vector_tpl<ware_t>, & tmp, *warray) {
-			// skip empty entries
-			if(tmp.menge==0  ||  w.get_index()!=tmp.get_index()  ||  w.get_zielpos()!=tmp.get_zielpos()) {
+	goods_store_t *store = waren[w.get_besch()->get_catg_index()];
+	if(store!=NULL) {
+		const uint64 key = goods_store_t::get_factory_key( w.get_index(), w.get_zielpos() );
+		FOR(vector_tpl<goods_bucket_t *>, const bucket, store->get_buckets()) {
+			const uint32 i = bucket->lower_bound(key);
+			if(  i >= bucket->waren.get_count()  ||  (goods_store_t::get_destination_key( bucket->waren[i] ) >> 16) != (key >> 16)  ) {
 				continue;
 			}
 
-			// not too much?
-			if(tmp.menge > menge) {
-				// not all can be loaded
-				tmp.menge -= menge;
-				w.menge = menge;
-			}
-			else {
-				// leave an empty entry => joining will more often work
-				w.menge = tmp.menge;
-				tmp.menge = 0;
-			}
+			store->take( bucket, i, menge, w );
+			store->compact( bucket );
 			book(w.menge, HALT_ARRIVED);
 			fabrik_t::update_transit( &w, false );
 			resort_freight_info = true;
@@ -1878,9 +2492,40 @@ void haltestelle_t::fetch_goods( slist_tpl<ware_t> &load, const ware_besch_t *go
 	// prissi: first iterate over the next stop, then over the ware
 	// might be a little slower, but ensures that passengers to nearest stop are served first
 	// this allows for separate high speed and normal service
-	vector_tpl<ware_t> *warray = waren[good_category->get_catg_index()];
+	goods_store_t *store = waren[good_category->get_catg_index()];
+
+	if(  store  &&  !store->empty()  ) {
+
+		// goods without route -> returning passengers/mail
+		// (searched again only for new packets or when the connections changed)
+		goods_bucket_t *unrouted = store->get_bucket( halthandle_t() );
+		if(  unrouted  &&  (store->unrouted_version != routing_version  ||  store->unrouted_count != unrouted->waren.get_count())  ) {
+			// take them all out first, joining may change the buckets
+			vector_tpl<ware_t> unrouted_waren( unrouted->waren.get_count() );
+			for(  uint32 i=0;  i<unrouted->waren.get_count();  i++  ) {
+				ware_t tmp;
+				store->take( unrouted, i, unrouted->waren[i].menge, tmp );
+				unrouted_waren.append( tmp );
+			}
+			store->compact( unrouted );
+
+			FOR(vector_tpl<ware_t>, tmp, unrouted_waren) {
+				search_route_resumable(tmp);
+				if(  !tmp.get_ziel().is_bound()  ) {
+					// no route anymore
+					continue;
+				}
+				if(  !tmp.get_zwischenziel().is_bound()  ||  !store->join(tmp, true)  ) {
+					// also goods still without next stop keep waiting
+					store->add(tmp);
+				}
+			}
+			// remember the failed searches
+			unrouted = store->get_bucket( halthandle_t() );
+			store->unrouted_version = routing_version;
+			store->unrouted_count = unrouted ? unrouted->waren.get_count() : 0;
+		}
 
-	if(  warray  &&  !warray->empty()  ) {
 		// da wir schon an der aktuellem haltestelle halten
 		// startet die schleife ab 1, d.h. dem naechsten halt
 		const uint8 count = schedule->get_count();
@@ -1900,68 +2545,39 @@ void haltestelle_t::fetch_goods( slist_tpl<ware_t> &load, const ware_besch_t *go
 					}
 				}
 			}
-			else {
+			else if(  goods_bucket_t *bucket = store->get_bucket(plan_halt)  ) {
+
+				// do not go for transfer to overcrowded transfer stop
+				const bool only_to_plan_halt = welt->get_settings().is_avoid_overcrowding()  &&  plan_halt->is_overcrowded(good_category->get_catg_index());
 
 				// The random offset will ensure that all goods have an equal chance to be loaded.
-				uint32 offset = simrand(warray->get_count());
-				for(  uint32 i=0;  i<warray->get_count();  i++  ) {
-					ware_t &tmp = (*warray)[ i+offset ];
+				const uint32 bucket_count = bucket->waren.get_count();
+				uint32 offset = bucket_count > 0 ? simrand(bucket_count) : 0;
+				for(  uint32 j=0;  j<bucket_count  &&  requested_amount>0;  j++  ) {
+					const uint32 index = j+offset;
 
 					// prevent overflow (faster than division)
-					if(  i+offset+1>=warray->get_count()  ) {
-						offset -= warray->get_count();
+					if(  j+offset+1>=bucket_count  ) {
+						offset -= bucket_count;
 					}
 
-					// skip empty entries
-					if(tmp.menge==0) {
+					if(  only_to_plan_halt  &&  bucket->waren[index].get_ziel() != plan_halt  ) {
 						continue;
 					}
 
-					// goods without route -> returning passengers/mail
-					if(  !tmp.get_zwischenziel().is_bound()  ) {
-						search_route_resumable(tmp);
-						if (!tmp.get_ziel().is_bound()) {
-							// no route anymore
-							tmp.menge = 0;
-							continue;
-						}
-					}
-
-					// compatible car and right target stop?
-					if(  tmp.get_zwischenziel()==plan_halt  ) {
-
-						if(  plan_halt->is_overcrowded(good_category->get_catg_index())  ) {
-							if (welt->get_settings().is_avoid_overcrowding() && tmp.get_ziel() != plan_halt) {
-								// do not go for transfer to overcrowded transfer stop
-								continue;
-							}
-						}
-
-						// not too much?
-						ware_t neu(tmp);
-						if(  tmp.menge > requested_amount  ) {
-							// not all can be loaded
-							neu.menge = requested_amount;
-							tmp.menge -= requested_amount;
-							requested_amount = 0;
-						}
-						else {
-							requested_amount -= tmp.menge;
-							// leave an empty entry => joining will more often work
-							tmp.menge = 0;
-						}
-						load.insert(neu);
-
-						book(neu.menge, HALT_DEPARTED);
-						resort_freight_info = true;
+					ware_t neu;
+					store->take( bucket, index, requested_amount, neu );
+					requested_amount -= neu.menge;
+					load.insert(neu);
 
-						if (requested_amount==0) {
-							return;
-						}
-					}
+					book(neu.menge, HALT_DEPARTED);
+					resort_freight_info = true;
 				}
+				store->compact( bucket );
 
-				// nothing there to load
+				if (requested_amount==0) {
+					return;
+				}
 			}
 		}
 	}
@@ -1971,51 +2587,27 @@ void haltestelle_t::fetch_goods( slist_tpl<ware_t> &load, const ware_besch_t *go
 
 uint32 haltestelle_t::get_ware_summe(const ware_besch_t *wtyp) const
 {
-	int sum = 0;
-	const vector_tpl<ware_t> * warray = waren[wtyp->get_catg_index()];
-	if(warray!=NULL) {
-		FOR(vector_tpl<ware_t>, const& i, *warray) {
-			if (wtyp->get_index() == i.get_index()) {
-				sum += i.menge;
-			}
-		}
-	}
-	return sum;
+	const goods_store_t *store = waren[wtyp->get_catg_index()];
+	return store ? store->get_summe( wtyp->get_index() ) : 0;
 }
 
 
 
 uint32 haltestelle_t::get_ware_fuer_zielpos(const ware_besch_t *wtyp, const koord zielpos) const
 {
-	const vector_tpl<ware_t> * warray = waren[wtyp->get_catg_index()];
-	if(warray!=NULL) {
-		FOR(vector_tpl<ware_t>, const& ware, *warray) {
-			if(wtyp->get_index()==ware.get_index()  &&  ware.get_zielpos()==zielpos) {
-				return ware.menge;
-			}
-		}
-	}
-	return 0;
+	const goods_store_t *store = waren[wtyp->get_catg_index()];
+	return store ? store->get_summe( wtyp->get_index(), zielpos ) : 0;
 }
 
 
 bool haltestelle_t::vereinige_waren(const ware_t &ware)
 {
 	// pruefen ob die ware mit bereits wartender ware vereinigt werden kann
-	vector_tpl<ware_t> * warray = waren[ware.get_besch()->get_catg_index()];
-	if(warray!=NULL) {
-		FOR(vector_tpl<ware_t>, & tmp, *warray) {
-			// join packets with same destination
-			if(ware.same_destination(tmp)) {
-				if(  ware.get_zwischenziel().is_bound()  &&  ware.get_zwischenziel()!=self  ) {
-					// update route if there is newer route
-					tmp.set_zwischenziel( ware.get_zwischenziel() );
-				}
-				tmp.menge += ware.menge;
-				resort_freight_info = true;
-				return true;
-			}
-		}
+	goods_store_t *store = waren[ware.get_besch()->get_catg_index()];
+	// update route if there is newer route
+	if(  store!=NULL  &&  store->join( ware, ware.get_zwischenziel().is_bound()  &&  ware.get_zwischenziel()!=self )  ) {
+		resort_freight_info = true;
+		return true;
 	}
 	return false;
 }
@@ -2027,22 +2619,14 @@ bool haltestelle_t::vereinige_waren(const ware_t &ware)
 void haltestelle_t::add_ware_to_halt(ware_t ware)
 {
 	// now we have to add the ware to the stop
-	vector_tpl<ware_t> * warray = waren[ware.get_besch()->get_catg_index()];
-	if(warray==NULL) {
+	goods_store_t *store = waren[ware.get_besch()->get_catg_index()];
+	if(store==NULL) {
 		// this type was not stored here before ...
-		warray = new vector_tpl<ware_t>(4);
-		waren[ware.get_besch()->get_catg_index()] = warray;
+		store = new goods_store_t();
+		waren[ware.get_besch()->get_catg_index()] = store;
 	}
-	// the ware will be put into the first entry with menge==0
 	resort_freight_info = true;
-	FOR(vector_tpl<ware_t>, & i, *warray) {
-		if (i.menge == 0) {
-			i = ware;
-			return;
-		}
-	}
-	// here, if no free entries found
-	warray->append(ware);
+	store->add(ware);
 }
 
 
@@ -2174,10 +2758,12 @@ void haltestelle_t::get_freight_info(cbuffer_t & buf)
 		resort_freight_info = false;
 		buf.clear();
 
+		vector_tpl<ware_t> warray;
 		for(unsigned i=0; i<warenbauer_t::get_max_catg_index(); i++) {
-			const vector_tpl<ware_t> * warray = waren[i];
-			if(warray) {
-				freight_list_sorter_t::sort_freight(*warray, buf, (freight_list_sorter_t::sort_mode_t)sortierung, NULL, "waiting");
+			if(waren[i]) {
+				warray.clear();
+				waren[i]->collect(warray);
+				freight_list_sorter_t::sort_freight(warray, buf, (freight_list_sorter_t::sort_mode_t)sortierung, NULL, "waiting");
 			}
 		}
 	}
@@ -2361,10 +2947,11 @@ void haltestelle_t::transfer_goods(halthandle_t halt)
 	}
 	// transfer goods to halt
 	for(uint8 i=0; i<warenbauer_t::get_max_catg_index(); i++) {
-		const vector_tpl<ware_t> * warray = waren[i];
-		if (warray) {
-			FOR(vector_tpl<ware_t>, const& j, *warray) {
-				halt->add_ware_to_halt(j);
+		if (waren[i]) {
+			FOR(vector_tpl<goods_bucket_t *>, const bucket, waren[i]->get_buckets()) {
+				FOR(vector_tpl<ware_t>, const& j, bucket->waren) {
+					halt->add_ware_to_halt(j);
+				}
 			}
 			delete waren[i];
 			waren[i] = NULL;
@@ -2609,20 +3196,22 @@ void haltestelle_t::rdwr(loadsave_t *file)
 	init_pos = tiles.empty() ? koord::invalid : tiles.front().grund->get_pos().get_2d();
 	if(file->is_saving()) {
 		const char *s;
+		vector_tpl<ware_t> warray;
 		for(unsigned i=0; i<warenbauer_t::get_max_catg_index(); i++) {
-			vector_tpl<ware_t> *warray = waren[i];
-			if(warray) {
+			if(waren[i]) {
+				warray.clear();
+				waren[i]->collect(warray);
 				s = "y";	// needs to be non-empty
 				file->rdwr_str(s);
 				if(  file->get_version() <= 112002  ) {
-					uint16 count = warray->get_count();
+					uint16 count = warray.get_count();
 					file->rdwr_short(count);
 				}
 				else {
-					uint32 count = warray->get_count();
+					uint32 count = warray.get_count();
 					file->rdwr_long(count);
 				}
-				FOR(vector_tpl<ware_t>, & ware, *warray) {
+				FOR(vector_tpl<ware_t>, & ware, warray) {
 					ware.rdwr(file);
 				}
 			}
@@ -2708,22 +3297,17 @@ void haltestelle_t::finish_rd()
 	stale_convois.clear();
 	stale_lines.clear();
 	// fix good destination coordinates
+	vector_tpl<ware_t> warray;
 	for(unsigned i=0; i<warenbauer_t::get_max_catg_index(); i++) {
 		if(waren[i]) {
-			vector_tpl<ware_t> * warray = waren[i];
-			FOR(vector_tpl<ware_t>, & j, *warray) {
+			// sort in again, since destinations and next stops may have changed
+			warray.clear();
+			waren[i]->extract(warray);
+			FOR(vector_tpl<ware_t>, & j, warray) {
 				j.finish_rd(welt);
-			}
-			// merge identical entries (should only happen with old games)
-			for(unsigned j=0; j<warray->get_count(); j++) {
-				if(  (*warray)[j].menge==0  ) {
-					continue;
-				}
-				for(unsigned k=j+1; k<warray->get_count(); k++) {
-					if(  (*warray)[k].menge>0  &&  (*warray)[j].same_destination( (*warray)[k] )  ) {
-						(*warray)[j].menge += (*warray)[k].menge;
-						(*warray)[k].menge = 0;
-					}
+				// merge identical entries (should only happen with old games)
+				if(  !waren[i]->join(j, false)  ) {
+					waren[i]->add(j);
 				}
 			}
 		}
@@ -14,7 +14,9 @@
 
 #include "simobj.h"
 #include "display/simgraph.h"
+#include "simconst.h"
 #include "simtypes.h"
+#include "simware.h"
 
 #include "bauer/warenbauer.h"
 
@@ -140,6 +142,7 @@ public:
 
 	/**
 	 * Handles changes of schedules and the resulting re-routing.
+	 * Reconnecting and rerouting of all halts is done in one call, in parallel if there are several threads.
 	 */
 	static void step_all();
 
@@ -248,6 +251,35 @@ public:
 private:
 	slist_tpl<tile_t> tiles;
 
+#	define UNDECIDED_CONNECTED_COMPONENT (0xffff)
+
+	/**
+	 * Precomputed best route from a halt to one halt of its connected component
+	 */
+	struct routing_entry_t {
+		/// weight as in search_route(), 65535 if not reachable
+		uint16 weight;
+		/// next transfer (zwischenziel) when leaving the origin halt
+		halthandle_t first_hop;
+		/// halt before the destination, next transfer of the return trip
+		halthandle_t previous;
+	};
+
+	/**
+	 * Best routes from a halt to all halts of its connected component for one goods category.
+	 * Only used if settings_t::is_halt_routing_table() is set.
+	 */
+	struct routing_row_t {
+		/// connected component and max transfers when built; the row is invalid if they changed
+		uint16 component;
+		uint16 max_transfers;
+		/// indexed by link_t::catg_component_index of the destination
+		routing_entry_t *entries;
+		uint16 count;
+
+		routing_row_t() : component(UNDECIDED_CONNECTED_COMPONENT), max_transfers(0), entries(NULL), count(0) {}
+		~routing_row_t() { delete [] entries; }
+	};
 
 	/**
 	 * Stores information about link to cargo network of a certain category
@@ -276,15 +308,28 @@ private:
 		 */
 		uint16 catg_connected_component;
 
-#		define UNDECIDED_CONNECTED_COMPONENT (0xffff)
+		/// position of this halt in its connected component and number of halts in it
+		uint16 catg_component_index;
+		uint16 catg_component_size;
 
-		link_t() { clear(); }
+		/// routes to all halts of the connected component, may be outdated or NULL
+		routing_row_t *routing_row;
+
+		/// connections changed since the last rebuild of the connected components, so all routes through them are outdated
+		bool routing_changed;
+		/// component before the change
+		uint16 routing_changed_component;
+
+		link_t() : routing_row(NULL), routing_changed(false) { clear(); }
+		~link_t() { delete routing_row; }
 
 		void clear()
 		{
 			connections.clear();
 			is_transfer = false;
 			catg_connected_component = UNDECIDED_CONNECTED_COMPONENT;
+			catg_component_index = 0;
+			catg_component_size = 0;
 		}
 	};
 
@@ -303,12 +348,104 @@ private:
 	 * Also sets connection_t::is_transfer.
 	 * @param catg category of cargo network
 	 * @param comp number of component
+	 * @param component_halts all halts of this component, gives their catg_component_index
+	 */
+	void fill_connected_component(uint8 catg, uint16 comp, vector_tpl<halthandle_t> &component_halts);
+
+
+	/**
+	 * Waiting goods of one category, which all travel to the same next transfer stop.
+	 * The packets are sorted by destination (see get_destination_key()),
+	 * so joining needs only a binary search.
 	 */
-	void fill_connected_component(uint8 catg, uint16 comp);
+	class goods_bucket_t
+	{
+	public:
+		halthandle_t zwischenziel;
+		vector_tpl<ware_t> waren;
+
+		goods_bucket_t(halthandle_t zwischenziel) : zwischenziel(zwischenziel), waren(4) {}
+
+		/// @return index of the first packet with a key not smaller than @p key
+		uint32 lower_bound(uint64 key) const;
+	};
+
+	/**
+	 * All waiting goods of one category, bucketed by their next transfer stop.
+	 * Loading only visits the buckets of the stops of the schedule,
+	 * the waiting amounts per good are updated on every change.
+	 */
+	class goods_store_t
+	{
+		vector_tpl<goods_bucket_t *> buckets;
+
+		/// waiting amount for each ware index
+		vector_tpl<uint32> summe;
+
+		/// @param delta change of waiting amount of the good of this packet
+		void book_summe(const ware_t &ware, sint32 delta);
+
+		/// inserts @p ware into the bucket of its next transfer stop (without booking)
+		void insert(const ware_t &ware);
+
+	public:
+		/// routing_version and number of packets, when fetch_goods() found no route for the goods without next stop
+		uint32 unrouted_version;
+		uint32 unrouted_count;
 
+		goods_store_t() : buckets(4), unrouted_version(0), unrouted_count(0) {}
+		~goods_store_t();
+
+		/**
+		 * Same as ware_t::same_destination(): goods for the same factory sort by target position.
+		 * Goods with the same good and target position are therefore next to each other.
+		 */
+		static uint64 get_destination_key(const ware_t &ware);
+
+		/// smallest key of all goods of type @p index for the factory at @p zielpos
+		static uint64 get_factory_key(uint8 index, koord zielpos);
+
+		const vector_tpl<goods_bucket_t *> &get_buckets() const { return buckets; }
+
+		/// @return bucket for goods with this next transfer stop, NULL if there is none
+		goods_bucket_t *get_bucket(halthandle_t zwischenziel) const;
+
+		/// true, if no goods are waiting
+		bool empty() const;
+
+		/**
+		 * Adds the amount of @p ware to a packet with the same destination.
+		 * @param update_route if true the packet moves to the bucket of the next transfer stop of @p ware
+		 * @return false, if there is no such packet
+		 */
+		bool join(const ware_t &ware, bool update_route);
+
+		/// adds @p ware as a new packet
+		void add(const ware_t &ware);
+
+		/// takes up to @p menge units from packet @p index of @p bucket into @p ware
+		void take(goods_bucket_t *bucket, uint32 index, uint32 menge, ware_t &ware);
+
+		/// removes the packets emptied by take(), and the bucket if it is empty then
+		void compact(goods_bucket_t *bucket);
+
+		/// deletes @p bucket if no goods are left in it
+		void free_if_empty(goods_bucket_t *bucket);
+
+		/// appends all packets to @p list
+		void collect(vector_tpl<ware_t> &list) const;
+
+		/// moves all packets into @p list and empties the store
+		void extract(vector_tpl<ware_t> &list);
+
+		uint32 get_summe(uint8 index) const { return index < summe.get_count() ? summe[index] : 0; }
+
+		/// total amount of good @p index for the factory at @p zielpos
+		uint32 get_summe(uint8 index, koord zielpos) const;
+	};
 
 	// Array with different categories that contains all waiting goods at this stop
-	vector_tpl<ware_t> **waren;
+	goods_store_t **waren;
 
 	/**
 	 * Liste der angeschlossenen Fabriken
@@ -332,8 +469,11 @@ private:
 	 * Reconnect and reroute if counter different from welt->get_schedule_counter()
 	 */
 	static uint8 reconnect_counter;
-	// since we do partial routing, we remember the last offset
-	uint8 last_catg_index;
+
+	/**
+	 * Increased by rebuild_connected_components(), i.e. whenever routes may have changed
+	 */
+	static uint32 routing_version;
 
 	/* station flags (most what enabled) */
 	uint8 enables;
@@ -376,10 +516,9 @@ public:
 	/**
 	* Called after schedule calculation of all stations is finished
 	* will distribute the goods to changed routes (if there are any)
-	* returns true upon completion
 	* @author Hj. Malthaner
 	*/
-	bool reroute_goods(sint16 &units_remaining);
+	void reroute_goods();
 
 	/**
 	 * getter/setter for sortby
@@ -448,11 +587,6 @@ public:
 
 	const slist_tpl<fabrik_t*>& get_fab_list() const { return fab_list; }
 
-	/**
-	 * called regularly to update status and reroute stuff
-	 * @author Hj. Malthaner
-	 */
-	bool step(uint8 what, sint16 &units_remaining);
 
 	/**
 	 * Called every month/every 24 game hours
@@ -487,25 +621,136 @@ private:
 		bool overcrowded:1;
 	};
 
-	// store the best weight so far for a halt, and indicate whether it is a destination
-	static halt_data_t halt_data[65536];
+	/**
+	 * All data of a route search; one per thread, so route searches can run in parallel.
+	 * Also holds the scratch space of rebuild_connections().
+	 */
+	class search_context_t
+	{
+	public:
+		// store the best weight so far for a halt, and indicate whether it is a destination
+		halt_data_t halt_data[65536];
+
+		// for efficient retrieval of the node with the smallest weight
+		binary_heap_tpl<route_node_t> open_list;
+
+		/**
+		 * Markers used in route searching to avoid processing the same halt more than once
+		 * @author Knightly
+		 */
+		uint8 markers[65536];
+		uint8 current_marker;
+
+		// destination halts and their connected components in search_route()
+		vector_tpl<halthandle_t> end_halts;
+		vector_tpl<uint16> end_conn_comp;
+
+		/**
+		 * Remember last route search start and catg to resume search
+		 * @author dwachs
+		 */
+		halthandle_t last_search_origin;
+		uint8        last_search_ware_catg_idx;
+		uint16       allocation_pointer;
+		// remember destination nodes, to reset them before returning
+		vector_tpl<uint16> dest_indices;
+
+		// Knightly : halts which either immediately precede or succeed self halt in serving schedules
+		vector_tpl<halthandle_t> consecutive_halts[256];
+		// Dwachs : halts which either immediately precede or succeed self halt in currently processed schedule
+		vector_tpl<halthandle_t> consecutive_halts_fpl[256];
+		// Knightly : previous halt supporting the ware categories of the serving line
+		halthandle_t previous_halt[256];
+		// connections before rebuilding, to find out whether the routing tables are still valid
+		vector_tpl<connection_t> old_connections[256];
+
+		search_context_t() : current_marker(0), end_halts(16), end_conn_comp(16), last_search_ware_catg_idx(255), allocation_pointer(0), dest_indices(16) { MEMZERO(markers); }
+	};
+
+	static search_context_t *search_contexts[MAX_THREADS];
+
+	/// allocates the context on first use; must not be called during parallel searches
+	static search_context_t &get_search_context(uint32 i);
+
+	static int search_route( search_context_t &context, const halthandle_t *const start_halts, const uint16 start_halt_count, const bool no_routing_over_overcrowding, ware_t &ware, ware_t *const return_ware );
+
+	void search_route_resumable( search_context_t &context, ware_t &ware );
 
-	// for efficient retrieval of the node with the smallest weight
-	static binary_heap_tpl<route_node_t> open_list;
+	sint32 rebuild_connections( search_context_t &context );
 
 	/**
-	 * Markers used in route searching to avoid processing the same halt more than once
-	 * @author Knightly
+	 * Searches new routes for all goods waiting here, as the first part of reroute_goods().
+	 * Only this halt is changed, so it can run in parallel for all halts.
+	 */
+	void search_reroute_goods( search_context_t &context );
+
+	/**
+	 * Second part of reroute_goods(): delivers the goods found at their destination
+	 * and removes the goods without route.
+	 */
+	void finish_reroute_goods();
+
+	/// goods for finish_reroute_goods()
+	vector_tpl<ware_t> rerouted_arrived;
+	vector_tpl<ware_t> rerouted_lost;
+
+	/**
+	 * Routing tables can be used, if enabled and the connections are complete.
+	 * They do not know about overcrowding, so routes avoiding overcrowded halts are still searched.
 	 */
-	static uint8 markers[65536];
-	static uint8 current_marker;
+	static bool use_routing_table( const bool no_routing_over_overcrowding );
+
+	bool is_routing_row_valid( const uint8 catg ) const;
+
+	/// (re)allocates the routing row for the current component; fill_routing_row() must be called before using it
+	void alloc_routing_row( const uint8 catg );
+
+	/// single source search to all halts of the connected component
+	void fill_routing_row( search_context_t &context, const uint8 catg );
+
+	/// @return valid routing row, which is built if needed (so this must not happen in parallel)
+	const routing_row_t *get_routing_row( search_context_t &context, const uint8 catg );
+
+	/// same as search_route(), but looks up the routes from all start halts to all end halts in the routing tables
+	static int search_route_table( search_context_t &context, const halthandle_t *const start_halts, const uint16 start_halt_count, const vector_tpl<halthandle_t> &end_halts, ware_t &ware, ware_t *const return_ware );
+
+	/// deletes all routing rows of changed connected components
+	static void invalidate_routing_tables();
 
 	/**
-	 * Remember last route search start and catg to resume search
-	 * @author dwachs
+	 * Route searches collected to run in parallel
+	 * start halts are stored in prepared_start_halts
 	 */
-	static halthandle_t last_search_origin;
-	static uint8        last_search_ware_catg_idx;
+	struct prepared_route_t
+	{
+		uint32 first_start_halt;
+		uint16 start_halt_count;
+		bool no_routing_over_overcrowding;
+		ware_t ware;
+		ware_t return_ware;
+		int result;
+	};
+	static vector_tpl<prepared_route_t> prepared_routes;
+	static vector_tpl<halthandle_t> prepared_start_halts;
+
+	/// routing rows allocated for the prepared routes, to be filled in parallel
+	struct prepared_row_t
+	{
+		halthandle_t halt;
+		uint8 catg;
+	};
+	static vector_tpl<prepared_row_t> prepared_rows;
+
+	/// work done by the threads: job(context,i) for all i<count
+	typedef void (*prepared_job_t)( search_context_t &context, uint32 i );
+	static prepared_job_t prepared_job;
+	static void run_prepared_jobs( prepared_job_t job, uint32 count );
+	static void prepared_route_job( search_context_t &context, uint32 i );
+	static void prepared_row_job( search_context_t &context, uint32 i );
+	static void reconnect_job( search_context_t &context, uint32 i );
+	static void reroute_job( search_context_t &context, uint32 i );
+
+	static void prepared_route_thread(void *, int thread_num);
 public:
 	enum routing_result_flags { NO_ROUTE=0, ROUTE_OK=1, ROUTE_WALK=2, ROUTE_OVERCROWDED=8 };
 
@@ -532,6 +777,27 @@ public:
 	 */
 	void search_route_resumable( ware_t &ware );
 
+	/**
+	 * Adds a search_route() with return ware to the routes searched by prepare_routes().
+	 * The halt data must not change until the results have been fetched.
+	 * @return index to get the result
+	 */
+	static uint32 add_prepared_route( const halthandle_t *const start_halts, const uint16 start_halt_count, const bool no_routing_over_overcrowding, const ware_t &ware, const ware_t &return_ware );
+
+	/**
+	 * Searches all added routes at once, in parallel if there are several threads.
+	 * The searches only read halt data, so the results do not depend on the number of threads.
+	 */
+	static void prepare_routes();
+
+	/**
+	 * @return result of the search_route() added with index @p i; copies the routed wares
+	 */
+	static int get_prepared_route( uint32 i, ware_t &ware, ware_t &return_ware );
+
+	/// discards all prepared routes
+	static void clear_prepared_routes();
+
 	bool get_pax_enabled()  const { return enables & PAX;  }
 	bool get_post_enabled() const { return enables & POST; }
 	bool get_ware_enabled() const { return enables & WARE; }
@@ -63,6 +63,7 @@
 #include "dataobj/settings.h"
 #include "dataobj/translator.h"
 #include "network/pakset_info.h"
+#include "network/network_journal.h"
 
 #include "besch/reader/obj_reader.h"
 #include "besch/sound_besch.h"
@@ -1004,6 +1005,11 @@ int simu_main(int argc, char** argv)
 	obj_reader_t::laden_abschliessen();
 	pakset_info_t::calculate_checksum();
 	pakset_info_t::debug();
+	{
+		image_memory_t mem;
+		display_get_image_memory( &mem );
+		dbg->message( "simu_main()", "%u images with %lu KB pixel data", mem.count, (unsigned long)(mem.base >> 10) );
+	}
 
 	dbg->important("Reading menu configuration ...");
 	tool_t::read_menu(env_t::objfilename);
@@ -1195,6 +1201,10 @@ DBG_MESSAGE("simmain","loadgame file found at %s",buffer);
 		intr_set(welt, view);
 		win_set_world(welt);
 		tool_t::toolbar_tool[0]->init(welt->get_active_player());
+		// recover the actions after the last checkpoint
+		if(  env_t::server  &&  env_t::server_checkpoint_interval > 0  ) {
+			network_journal_t::replay( welt );
+		}
 	}
 
 	welt->set_fast_forward(false);
@@ -74,7 +74,7 @@ obj_t::obj_t(loadsave_t *file)
 obj_t::obj_t(koord3d pos)
 {
 	init();
-	this->pos = pos;
+	set_pos( pos );
 }
 
 
@@ -12,6 +12,7 @@
 #include "display/simimg.h"
 #include "simcolor.h"
 #include "dataobj/koord3d.h"
+#include "display/simview.h"
 
 
 class cbuffer_t;
@@ -111,7 +112,13 @@ public:
 	 * routines to set, clear, get bit flags
 	 * @author Hj. Malthaner
 	 */
-	inline void set_flag(flag_values flag) {flags |= flag;}
+	inline void set_flag(flag_values flag) {
+		if(  flag == dirty  &&  !(flags & dirty)  ) {
+			// the display looks only at the reported tiles
+			karte_ansicht_t::mark_tile_changed( pos.get_2d() );
+		}
+		flags |= flag;
+	}
 	inline void clear_flag(flag_values flag) {flags &= ~flag;}
 	inline bool get_flag(flag_values flag) const {return ((flags & flag) != 0);}
 
@@ -293,7 +300,14 @@ public:
 	/**
 	 * set position - you would not have guessed it :)
 	 */
-	inline void set_pos(koord3d k) { if(k!=pos) { set_flag(dirty); pos = k;} }
+	inline void set_pos(koord3d k) {
+		if(  k != pos  ) {
+			pos = k;
+			// report the new tile, even if already dirty
+			flags &= ~dirty;
+			set_flag(dirty);
+		}
+	}
 
 	/**
 	 * put description of object into the buffer
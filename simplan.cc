@@ -44,6 +44,8 @@ void swap(planquadrat_t& a, planquadrat_t& b)
 	sim::swap(a.halt_list_count, b.halt_list_count);
 	sim::swap(a.data, b.data);
 	sim::swap(a.climate_data, b.climate_data);
+	sim::swap(a.kartenboden_hoehe, b.kartenboden_hoehe);
+	sim::swap(a.kartenboden_wasser, b.kartenboden_wasser);
 }
 
 // deletes also all grounds in this array!
@@ -71,6 +73,16 @@ planquadrat_t::~planquadrat_t()
 }
 
 
+void planquadrat_t::update_kartenboden_data()
+{
+	if(  ground_size > 0  ) {
+		const grund_t *gr = get_kartenboden();
+		kartenboden_hoehe = gr->get_hoehe();
+		kartenboden_wasser = gr->ist_wasser();
+	}
+}
+
+
 grund_t *planquadrat_t::get_boden_von_obj(obj_t *obj) const
 {
 	if(ground_size==1) {
@@ -96,6 +108,7 @@ void planquadrat_t::boden_hinzufuegen(grund_t *bd)
 		// completely empty
 		data.one = bd;
 		ground_size = 1;
+		update_kartenboden_data();
 		reliefkarte_t::get_karte()->calc_map_pixel(bd->get_pos().get_2d());
 		return;
 	}
@@ -168,6 +181,7 @@ bool planquadrat_t::boden_entfernen(grund_t *bd)
 					delete [] data.some;
 					data.one = tmp;
 				}
+				update_kartenboden_data();
 				return true;
 			}
 		}
@@ -189,6 +203,7 @@ void planquadrat_t::kartenboden_setzen(grund_t *bd)
 		ground_size = 1;
 		bd->set_kartenboden(true);
 	}
+	// calc_bild() updates also the data of the map ground here
 	bd->calc_bild();
 	reliefkarte_t::get_karte()->calc_map_pixel(bd->get_pos().get_2d());
 }
@@ -229,6 +244,7 @@ void planquadrat_t::boden_ersetzen(grund_t *alt, grund_t *neu)
 		}
 		delete alt;
 	}
+	update_kartenboden_data();
 }
 
 
@@ -300,6 +316,7 @@ void planquadrat_t::rdwr(loadsave_t *file, koord pos )
 				}
 			}
 		} while(gr != 0);
+		update_kartenboden_data();
 	}
 }
 
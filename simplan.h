@@ -37,6 +37,11 @@ private:
 	// stores climate related settings
 	uint8 climate_data;
 
+	// copy of height and water flag of the first (i.e. the map) ground,
+	// so lookups need not to touch the grund_t objects; see update_kartenboden_data()
+	sint8 kartenboden_hoehe;
+	bool kartenboden_wasser;
+
 	union DATA {
 		grund_t ** some;    // valid if capacity > 1
 		grund_t * one;      // valid if capacity == 1
@@ -47,7 +52,7 @@ public:
 	 * Constructs a planquadrat with initial capacity of one ground
 	 * @author Hansjrg Malthaner
 	 */
-	planquadrat_t() { ground_size = 0; climate_data = 0; data.one = NULL; halt_list_count = 0;  halt_list = NULL; }
+	planquadrat_t() { ground_size = 0; climate_data = 0; kartenboden_hoehe = 0; kartenboden_wasser = false; data.one = NULL; halt_list_count = 0;  halt_list = NULL; }
 
 	~planquadrat_t();
 
@@ -90,12 +95,15 @@ public:
 	inline grund_t *get_boden_in_hoehe(const sint16 z) const {
 		if(ground_size==1) {
 			// must be valid ground at this point!
-			if(  data.one->get_hoehe() == z  ) {
+			if(  kartenboden_hoehe == z  ) {
 				return data.one;
 			}
 		}
-		else {
-			for(  uint8 i = 0;  i < ground_size;  i++  ) {
+		else if(  ground_size > 1  ) {
+			if(  kartenboden_hoehe == z  ) {
+				return data.some[0];
+			}
+			for(  uint8 i = 1;  i < ground_size;  i++  ) {
 				if(  data.some[i]->get_hoehe() == z  ) {
 					return data.some[i];
 				}
@@ -104,6 +112,18 @@ public:
 		return NULL;
 	}
 
+	/**
+	 * Copies height and water flag of the first ground into this tile.
+	 * Must be called after one of them has changed; the setters of grund_t do this.
+	 */
+	void update_kartenboden_data();
+
+	/// @return height of the first ground (without touching it)
+	inline sint8 get_kartenboden_hoehe() const { return kartenboden_hoehe; }
+
+	/// @return true if the first ground is water (without touching it)
+	inline bool is_kartenboden_wasser() const { return kartenboden_wasser; }
+
 	/**
 	* returns normal ground (always first index)
 	* @return not defined if no ground (must not happen!)
@@ -78,6 +78,8 @@
 #include "network/network_file_transfer.h"
 #include "network/network_socket_list.h"
 #include "network/network_cmd_ingame.h"
+#include "network/network_journal.h"
+#include "network/checksum.h"
 #include "dataobj/ribi.h"
 #include "dataobj/translator.h"
 #include "dataobj/loadsave.h"
@@ -86,6 +88,7 @@
 #include "dataobj/environment.h"
 #include "dataobj/powernet.h"
 #include "dataobj/records.h"
+#include "dataobj/way_graph.h"
 
 #include "utils/cbuffer_t.h"
 #include "utils/simrandom.h"
@@ -99,6 +102,7 @@
 #include "bauer/wegbauer.h"
 #include "bauer/hausbauer.h"
 #include "bauer/vehikelbauer.h"
+#include "bauer/warenbauer.h"
 
 #include "besch/grund_besch.h"
 
@@ -127,11 +131,6 @@ stringhashtable_tpl<karte_t::missing_level_t>missing_pak_names;
 #include "utils/simthread.h"
 #include <semaphore.h>
 
-bool spawned_world_threads=false; // global job indicator array
-static simthread_barrier_t world_barrier_start;
-static simthread_barrier_t world_barrier_end;
-
-
 // to start a thread
 typedef struct{
 	karte_t *welt;
@@ -143,48 +142,33 @@ typedef struct{
 	sem_t* wait_for_previous;
 	sem_t* signal_to_next;
 	xy_loop_func function;
-	bool keep_running;
 } world_thread_param_t;
 
 
 // now the paramters
 static world_thread_param_t world_thread_param[MAX_THREADS];
 
-void *karte_t::world_xy_loop_thread(void *ptr)
+void karte_t::world_xy_loop_thread(void *, int thread_num)
 {
-	world_thread_param_t *param = reinterpret_cast<world_thread_param_t *>(ptr);
-	while(true) {
-		if(param->keep_running) {
-			simthread_barrier_wait( &world_barrier_start );	// wait for all to start
-		}
+	world_thread_param_t *param = &world_thread_param[thread_num];
 
-		sint16 x_min = 0;
-		sint16 x_max = param->x_step;
+	sint16 x_min = 0;
+	sint16 x_max = param->x_step;
 
-		while(  x_min < param->x_world_max  ) {
-			// wait for predecessor to finish its block
-			if(  param->wait_for_previous  ) {
-				sem_wait( param->wait_for_previous );
-			}
-			(param->welt->*(param->function))(x_min, x_max, param->y_min, param->y_max);
-
-			// signal to next thread that we finished one block
-			if(  param->signal_to_next  ) {
-				sem_post( param->signal_to_next );
-			}
-			x_min = x_max;
-			x_max = min(x_max + param->x_step, param->x_world_max);
+	while(  x_min < param->x_world_max  ) {
+		// wait for predecessor to finish its block
+		if(  param->wait_for_previous  ) {
+			sem_wait( param->wait_for_previous );
 		}
+		(param->welt->*(param->function))(x_min, x_max, param->y_min, param->y_max);
 
-		if(param->keep_running) {
-			simthread_barrier_wait( &world_barrier_end );	// wait for all to finish
-		}
-		else {
-			return NULL;
+		// signal to next thread that we finished one block
+		if(  param->signal_to_next  ) {
+			sem_post( param->signal_to_next );
 		}
+		x_min = x_max;
+		x_max = min(x_max + param->x_step, param->x_world_max);
 	}
-
-	return ptr;
 }
 #endif
 
@@ -217,38 +201,10 @@ void karte_t::world_xy_loop(xy_loop_func function, uint8 flags)
 
 		world_thread_param[t].wait_for_previous = sync_x_steps  &&  t > 0 ? &sems[t-1] : NULL;
 		world_thread_param[t].signal_to_next    = sync_x_steps  &&  t < env_t::num_threads - 1 ? &sems[t] : NULL;
-
-		world_thread_param[t].keep_running = t < env_t::num_threads - 1;
-	}
-
-	if(  !spawned_world_threads  ) {
-		// we can do the parallel display using posix threads ...
-		pthread_t thread[MAX_THREADS];
-		/* Initialize and set thread detached attribute */
-		pthread_attr_t attr;
-		pthread_attr_init( &attr );
-		pthread_attr_setdetachstate( &attr, PTHREAD_CREATE_DETACHED );
-		// init barrier
-		simthread_barrier_init( &world_barrier_start, NULL, env_t::num_threads );
-		simthread_barrier_init( &world_barrier_end, NULL, env_t::num_threads );
-
-		for(  int t = 0;  t < env_t::num_threads - 1;  t++  ) {
-			if(  pthread_create( &thread[t], &attr, world_xy_loop_thread, (void *)&world_thread_param[t] )  ) {
-				dbg->fatal( "karte_t::world_xy_loop()", "cannot multithread, error at thread #%i", t+1 );
-				return;
-			}
-		}
-		spawned_world_threads = true;
-		pthread_attr_destroy( &attr );
 	}
 
 	// and start processing
-	simthread_barrier_wait( &world_barrier_start );
-
-	// the last we can run ourselves
-	world_xy_loop_thread(&world_thread_param[env_t::num_threads-1]);
-
-	simthread_barrier_wait( &world_barrier_end );
+	simthread_run_parallel( world_xy_loop_thread, NULL );
 
 	// return from thread
 	for(  int t = 0;  t < env_t::num_threads - 1;  t++  ) {
@@ -275,12 +231,143 @@ void checklist_t::rdwr(memory_rw_t *buffer)
 }
 
 
+void checklist_t::rdwr_digest(memory_rw_t *buffer)
+{
+	buffer->rdwr_bool(has_digest);
+	if(  has_digest  ) {
+		for(  int i=0;  i<DIGEST_COUNT;  i++  ) {
+			buffer->rdwr_long(digest[i]);
+		}
+	}
+}
+
+
 int checklist_t::print(char *buffer, const char *entity) const
 {
 	return sprintf(buffer, "%s=[rand=%u halt=%u line=%u cnvy=%u] ", entity, random_seed, halt_entry, line_entry, convoy_entry);
 }
 
 
+uint32 checklist_t::compare_digest(const checklist_t &other) const
+{
+	uint32 differ = 0;
+	if(  has_digest  &&  other.has_digest  ) {
+		for(  int i=0;  i<DIGEST_COUNT;  i++  ) {
+			if(  digest[i] != other.digest[i]  ) {
+				differ |= 1 << i;
+			}
+		}
+	}
+	return differ;
+}
+
+
+const char *checklist_t::get_digest_name(int i)
+{
+	static const char *names[DIGEST_COUNT] = { "convoys", "halts", "factories", "players" };
+	return names[i];
+}
+
+
+/**
+ * The digest of every CHECKLIST_DIGEST_INTERVAL-th object of one part of the world state, starting with @p slice
+ */
+static uint32 calc_checklist_digest_part(const karte_t *welt, int part, uint32 slice)
+{
+	checksum_t chk;
+	switch(  part  ) {
+		case checklist_t::DIGEST_CONVOYS: {
+			const vector_tpl<convoihandle_t> &convoys = welt->convoys();
+			for(  uint32 i=slice;  i<convoys.get_count();  i+=CHECKLIST_DIGEST_INTERVAL  ) {
+				const convoihandle_t cnv = convoys[i];
+				chk.input( cnv.get_id() );
+				chk.input( (sint32)cnv->get_state() );
+				chk.input( cnv->get_akt_speed() );
+				const koord3d pos = cnv->get_pos();
+				chk.input( pos.x );
+				chk.input( pos.y );
+				chk.input( pos.z );
+			}
+			break;
+		}
+
+		case checklist_t::DIGEST_HALTS: {
+			const vector_tpl<halthandle_t> &halts = haltestelle_t::get_alle_haltestellen();
+			for(  uint32 i=slice;  i<halts.get_count();  i+=CHECKLIST_DIGEST_INTERVAL  ) {
+				const halthandle_t halt = halts[i];
+				chk.input( halt.get_id() );
+				for(  uint16 j=0;  j<warenbauer_t::get_waren_anzahl();  j++  ) {
+					chk.input( halt->get_ware_summe( warenbauer_t::get_info(j) ) );
+				}
+			}
+			break;
+		}
+
+		case checklist_t::DIGEST_FACTORIES: {
+			uint32 i = 0;
+			FOR(slist_tpl<fabrik_t *>, const fab, welt->get_fab_list()) {
+				if(  (i++ % CHECKLIST_DIGEST_INTERVAL) != slice  ) {
+					continue;
+				}
+				chk.input( fab->get_pos().x );
+				chk.input( fab->get_pos().y );
+				FOR(array_tpl<ware_production_t>, const& in, fab->get_eingang()) {
+					chk.input( in.menge );
+				}
+				FOR(array_tpl<ware_production_t>, const& out, fab->get_ausgang()) {
+					chk.input( out.menge );
+				}
+			}
+			break;
+		}
+
+		case checklist_t::DIGEST_PLAYERS:
+			if(  slice==0  ) {
+				for(  uint8 i=0;  i<MAX_PLAYER_COUNT;  i++  ) {
+					if(  player_t *player = welt->get_player(i)  ) {
+						chk.input( i );
+						chk.input( player->get_finance()->get_account_balance() );
+					}
+				}
+			}
+			break;
+	}
+	return chk.get_short_digest();
+}
+
+
+void karte_t::update_checklist_digest()
+{
+	const uint32 slice = sync_steps % CHECKLIST_DIGEST_INTERVAL;
+	if(  slice==0  ) {
+		// the interval before is complete
+		if(  checklist_digest_valid  &&  checklist_digest_next==sync_steps  ) {
+			checklist_t &chklst = LCHKLST(sync_steps);
+			for(  int i=0;  i<checklist_t::DIGEST_COUNT;  i++  ) {
+				chklst.digest[i] = checklist_digest_sum[i];
+			}
+			chklst.has_digest = true;
+		}
+		for(  int i=0;  i<checklist_t::DIGEST_COUNT;  i++  ) {
+			checklist_digest_sum[i] = 0;
+		}
+		checklist_digest_valid = true;
+	}
+	else if(  checklist_digest_next!=sync_steps  ) {
+		// joined, loaded or skipped steps in between
+		checklist_digest_valid = false;
+	}
+	checklist_digest_next = sync_steps + 1;
+
+	if(  checklist_digest_valid  ) {
+		for(  int i=0;  i<checklist_t::DIGEST_COUNT;  i++  ) {
+			const uint32 sum = checklist_digest_sum[i];
+			checklist_digest_sum[i] = ((sum << 5) | (sum >> 27)) ^ calc_checklist_digest_part( this, i, slice );
+		}
+	}
+}
+
+
 void karte_t::recalc_season_snowline(bool set_pending)
 {
 	static const sint8 mfactor[12] = { 99, 95, 80, 50, 25, 10, 0, 5, 20, 35, 65, 85 };
@@ -686,6 +773,12 @@ DBG_MESSAGE("karte_t::destroy()", "destroying world");
 
 	loadingscreen_t ls( translator::translate("Destroying map ..."), max_display_progress, true );
 
+	// no more route searches on this map
+	way_graph_t::reset();
+
+	// the file must be complete before we may quit
+	wait_for_background_save( false );
+
 	// rotate the map until it can be saved
 	nosave_warning = false;
 	if(  nosave  ) {
@@ -1496,6 +1589,7 @@ void karte_t::init(settings_t* const sets, sint8 const* const h_field)
 	steps = 0;
 	network_frame_count = 0;
 	sync_steps = 0;
+	checklist_digest_valid = false;
 	map_counter = 0;
 	recalc_average_speed();	// resets timeline
 	koord::locality_factor = settings.get_locality_factor( last_year );
@@ -1784,15 +1878,16 @@ void karte_t::create_beaches(  int xoff, int yoff  )
 	// bays have wide beaches
 	for(  uint16 iy = 0;  iy < size_y;  iy++  ) {
 		for(  uint16 ix = (iy >= yoff - 19) ? 0 : max( xoff - 19, 0 );  ix < size_x;  ix++  ) {
-			grund_t *gr = lookup_kartenboden_nocheck(ix,iy);
-			if(  gr->ist_wasser()  && gr->get_hoehe()==grundwasser  ) {
+			const planquadrat_t *pl = access_nocheck(ix,iy);
+			if(  pl->is_kartenboden_wasser()  &&  pl->get_kartenboden_hoehe()==grundwasser  ) {
+				grund_t *gr = pl->get_kartenboden();
 				koord k( ix, iy );
 				uint8 neighbour_water = 0;
 				bool water[8];
 				// check whether nearby tiles are water
 				for(  int i = 0;  i < 8;  i++  ) {
-					grund_t *gr2 = lookup_kartenboden( k + koord::neighbours[i] );
-					water[i] = (!gr2  ||  gr2->ist_wasser());
+					const planquadrat_t *pl2 = access( k + koord::neighbours[i] );
+					water[i] = (!pl2  ||  pl2->is_kartenboden_wasser());
 				}
 
 				// make a count of nearby tiles - where tiles on opposite (+-1 direction) sides are water these count much more so we don't block straits
@@ -1824,12 +1919,12 @@ void karte_t::create_beaches(  int xoff, int yoff  )
 	for(  uint16 iy = 0;  iy < size_y;  iy++  ) {
 		for(  uint16 ix = (iy >= yoff - 19) ? 0 : max( xoff - 19, 0 );  ix < size_x;  ix++  ) {
 			koord k( ix, iy );
-			grund_t *gr = lookup_kartenboden_nocheck(k);
-			if(  !gr->ist_wasser()  &&  gr->get_pos().z == grundwasser  ) {
+			const planquadrat_t *pl = access_nocheck(k);
+			if(  !pl->is_kartenboden_wasser()  &&  pl->get_kartenboden_hoehe() == grundwasser  ) {
 				uint8 neighbour_water = 0;
 				for(  int i = 0;  i < 8;  i++  ) {
-					grund_t *gr2 = lookup_kartenboden( k + koord::neighbours[i] );
-					if(  !gr2  ||  gr2->ist_wasser()  ) {
+					const planquadrat_t *pl2 = access( k + koord::neighbours[i] );
+					if(  !pl2  ||  pl2->is_kartenboden_wasser()  ) {
 						neighbour_water++;
 					}
 				}
@@ -1912,6 +2007,9 @@ void karte_t::enlarge_map(settings_t const* sets, sint8 const* const h_field)
 		grund_t::enlarge_map( new_groesse_x, new_groesse_y );
 	}
 
+	// the edge tiles at the old border will change
+	way_graph_t::reset();
+
 	planquadrat_t *new_plan = new planquadrat_t[new_groesse_x*new_groesse_y];
 	sint8 *new_grid_hgts = new sint8[(new_groesse_x + 1) * (new_groesse_y + 1)];
 	sint8 *new_water_hgts = new sint8[new_groesse_x * new_groesse_y];
@@ -2237,6 +2335,7 @@ karte_t::karte_t() :
 	last_step_ticks = 0;
 	server_last_announce_time = 0;
 	last_interaction = dr_time();
+	next_checkpoint_time = last_interaction;
 	step_mode = PAUSE_FLAG;
 	time_multiplier = 16;
 	next_step_time = last_step_time = 0;
@@ -2244,6 +2343,8 @@ karte_t::karte_t() :
 	idle_time = 0;
 	network_frame_count = 0;
 	sync_steps = 0;
+	checklist_digest_next = 0;
+	checklist_digest_valid = false;
 
 	for(  uint i=0;  i<MAX_PLAYER_COUNT;  i++  ) {
 		selected_tool[i] = tool_t::general_tool[TOOL_QUERY];
@@ -3370,6 +3471,7 @@ void karte_t::rotate90_plans(sint16 x_min, sint16 x_max, sint16 y_min, sint16 y_
 						for(  uint i = 0;  i < plan[nr].get_boden_count();  i++  ) {
 							plan[nr].get_boden_bei(i)->rotate90();
 						}
+						plan[nr].update_kartenboden_data();
 						// rotate climate transitions
 						rotate_transitions( koord( x, y ) );
 						// now: rotate all things on the map
@@ -3403,6 +3505,7 @@ void karte_t::rotate90_plans(sint16 x_min, sint16 x_max, sint16 y_min, sint16 y_
 						for(  uint i = 0;  i < rotate90_new_plan[new_nr].get_boden_count();  i++  ) {
 							rotate90_new_plan[new_nr].get_boden_bei(i)->rotate90();
 						}
+						rotate90_new_plan[new_nr].update_kartenboden_data();
 					}
 				}
 			}
@@ -3435,6 +3538,9 @@ DBG_MESSAGE( "karte_t::rotate90()", "called" );
 	//announce current target rotation
 	settings.rotate90();
 
+	// all positions will change
+	way_graph_t::reset();
+
 	// clear marked region
 	zeiger->change_pos( koord3d::invalid );
 
@@ -3670,6 +3776,60 @@ static volatile bool sync_step_running = false;
 static volatile bool sync_step_eyecandy_running = false;
 static volatile bool sync_way_eyecandy_running = false;
 
+
+/* the local part of the sync steps (sync_steppable::sync_step_local()) of a list
+ * is done first and in parallel, the rest then serially in the order of the list.
+ * sync_local_done[i] is set, when list[i] has already done its step.
+ */
+static const vector_tpl<sync_steppable *> *sync_local_list = NULL;
+static uint8 *sync_local_done = NULL;
+static uint32 sync_local_done_size = 0;
+static uint32 sync_local_delta_t = 0;
+
+static void sync_step_local_range(uint32 start, uint32 end)
+{
+	for(  uint32 i = start;  i < end;  i++  ) {
+		sync_local_done[i] = (*sync_local_list)[i]->sync_step_local( sync_local_delta_t );
+	}
+}
+
+
+#ifdef MULTI_THREAD
+static void sync_step_local_thread(void *, int t)
+{
+	// each thread takes a fixed part of the list
+	const uint32 count = sync_local_list->get_count();
+	sync_step_local_range( (count*t) / env_t::num_threads, (count*(t+1)) / env_t::num_threads );
+}
+#endif
+
+
+static void sync_step_local(const vector_tpl<sync_steppable *> &list, uint32 delta_t)
+{
+	const uint32 count = list.get_count();
+	if(  sync_local_done_size < count  ) {
+		delete [] sync_local_done;
+		sync_local_done_size = count + count/8 + 64;
+		sync_local_done = new uint8[sync_local_done_size];
+	}
+	sync_local_list = &list;
+	sync_local_delta_t = delta_t;
+
+	set_random_mode( INTERACTIVE_RANDOM ); // do not allow simrand() here!
+#ifdef MULTI_THREAD
+	// which steps are local does not depend on the threads, so this is only worth for long lists
+	if(  env_t::num_threads > 1  &&  count > 1024  ) {
+		simthread_run_parallel( sync_step_local_thread, NULL );
+	}
+	else
+#endif
+	{
+		sync_step_local_range( 0, count );
+	}
+	clear_random_mode( INTERACTIVE_RANDOM );
+	sync_local_list = NULL;
+}
+
 // handling animations and the like
 bool karte_t::sync_eyecandy_add(sync_steppable *obj)
 {
@@ -3811,9 +3971,12 @@ void karte_t::sync_way_eyecandy_step(uint32 delta_t)
 #else
 	static vector_tpl<sync_steppable *> sync_way_eyecandy_list_copy;
 	sync_way_eyecandy_list_copy.resize( (uint32) (sync_way_eyecandy_list.get_count()*1.1) );
-	FOR(vector_tpl<sync_steppable*>, const ss, sync_way_eyecandy_list) {
+	// pedestrians staying on their tile move in parallel, the others afterwards
+	sync_step_local( sync_way_eyecandy_list, delta_t );
+	for(  uint32 i = 0;  i < sync_way_eyecandy_list.get_count();  i++  ) {
+		sync_steppable *ss = sync_way_eyecandy_list[i];
 		// if false, then remove
-		if(!ss->sync_step(delta_t)) {
+		if(  !sync_local_done[i]  &&  !ss->sync_step(delta_t)  ) {
 			delete ss;
 		}
 		else {
@@ -3929,9 +4092,13 @@ void karte_t::sync_step(uint32 delta_t, bool sync, bool display )
 #else
 		static vector_tpl<sync_steppable *> sync_list_copy;
 		sync_list_copy.resize( sync_list.get_count() );
-		FOR(vector_tpl<sync_steppable*>, const ss, sync_list) {
+		// first everything which does not leave its tile (mostly city cars) in parallel
+		// then the rest in the order of the list, so all clients get the same results
+		sync_step_local( sync_list, delta_t );
+		for(  uint32 i = 0;  i < sync_list.get_count();  i++  ) {
+			sync_steppable *ss = sync_list[i];
 			// if false, then remove
-			if(!ss->sync_step(delta_t)) {
+			if(  !sync_local_done[i]  &&  !ss->sync_step(delta_t)  ) {
 				delete ss;
 			}
 			else {
@@ -4229,7 +4396,12 @@ void karte_t::new_month()
 	if( !env_t::networkmode  &&  env_t::autosave>0  &&  last_month%env_t::autosave==0  &&  !win_get_magic(magic_welt_gui_t)  ) {
 		char buf[128];
 		sprintf( buf, "save/autosave%02i.sve", last_month+1 );
-		save( buf, loadsave_t::autosave_mode, env_t::savegame_version_str, true );
+		if(  env_t::autosave_background  ) {
+			save_in_background( buf, loadsave_t::autosave_mode, env_t::savegame_version_str );
+		}
+		else {
+			save( buf, loadsave_t::autosave_mode, env_t::savegame_version_str, true );
+		}
 	}
 }
 
@@ -4481,6 +4653,15 @@ void karte_t::step()
 	INT_CHECK("karte_t::step");
 
 	DBG_DEBUG4("karte_t::step", "step convois");
+	// plan phase: first do the route searches and everything else
+	// which only reads the world of all convois at once, since they can run in parallel
+	FOR(vector_tpl<convoihandle_t>, const cnv, convoi_array) {
+		cnv->prepare_route();
+	}
+	route_t::prepare_searches(this);
+	convoi_t::plan_steps(convoi_array);
+
+	// commit phase: the order of the steps must be the same on all clients
 	// since convois will be deleted during stepping, we need to step backwards
 	for (size_t i = convoi_array.get_count(); i-- != 0;) {
 		convoihandle_t cnv = convoi_array[i];
@@ -4489,6 +4670,7 @@ void karte_t::step()
 			INT_CHECK("simworld 1947");
 		}
 	}
+	route_t::clear_prepared_searches();
 
 	// now step all towns (to generate passengers)
 	DBG_DEBUG4("karte_t::step", "step cities");
@@ -4497,6 +4679,8 @@ void karte_t::step()
 		i->step(delta_t);
 		bev += i->get_finance_history_month(0, HIST_CITICENS);
 	}
+	// the passengers generated by all cities are routed at once
+	stadt_t::route_passagiere();
 
 	// the inhabitants stuff
 	finance_history_month[0][WORLD_CITICENS] = bev;
@@ -4975,9 +5159,122 @@ bool karte_t::play_sound_area_clipped(koord const k, uint16 const idx) const
 }
 
 
+// the save currently written by the background thread
+static struct {
+	loadsave_t *file;
+	std::string filename;
+	std::string savename;
+	std::string error;
+	bool checkpoint; ///< server checkpoint: commit the journal when written
+} background_save;
+static bool background_save_running = false;
+#ifdef MULTI_THREAD
+static pthread_t background_save_thread;
+#endif
+
+
+static void *background_save_write(void *)
+{
+	const char *success = background_save.file->close_memory_to_file( background_save.savename.c_str() );
+	background_save.error = success ? success : "";
+	if(  success == NULL  &&  background_save.savename != background_save.filename  ) {
+		remove( background_save.filename.c_str() );
+		rename( background_save.savename.c_str(), background_save.filename.c_str() );
+	}
+	delete background_save.file;
+	background_save.file = NULL;
+	return NULL;
+}
+
+
+void karte_t::wait_for_background_save(bool show_error)
+{
+	if(  !background_save_running  ) {
+		return;
+	}
+#ifdef MULTI_THREAD
+	pthread_join( background_save_thread, NULL );
+#endif
+	background_save_running = false;
+	// since it was written in the background, errors are only shown now
+	if(  !background_save.error.empty()  ) {
+		dbg->error( "karte_t::wait_for_background_save()", "cannot write '%s': %s", background_save.filename.c_str(), background_save.error.c_str() );
+		if(  show_error  ) {
+			static char err_str[512];
+			sprintf( err_str, translator::translate("Error during saving:\n%s"), background_save.error.c_str() );
+			create_win( new news_img(err_str), w_time_delete, magic_none);
+		}
+	}
+	if(  background_save.checkpoint  ) {
+		network_journal_t::commit( background_save.error.empty() );
+	}
+}
+
+
+void karte_t::save_in_background(const char *filename, loadsave_t::mode_t savemode, const char *version_str, bool checkpoint )
+{
+DBG_MESSAGE("karte_t::save_in_background()", "saving game to '%s'", filename);
+	wait_for_background_save( true );
+
+	loadsave_t *file = new loadsave_t();
+	display_show_load_pointer( true );
+	file->wr_open_memory( savemode, env_t::objfilename.c_str(), version_str );
+	save( file, true );
+	reset_interaction();
+	display_show_load_pointer( false );
+
+	background_save.file = file;
+	background_save.filename = filename;
+	// never overwrite the old file with a half written one
+	background_save.savename = strstart( filename, "save/" ) ? std::string("save/_temp.sve") : std::string(filename) + ".tmp";
+	background_save.error.clear();
+	background_save.checkpoint = checkpoint;
+	if(  checkpoint  ) {
+		// commands executed from now on belong to this checkpoint
+		network_journal_t::start( ticks, sync_steps, true );
+	}
+#ifdef MULTI_THREAD
+	if(  pthread_create( &background_save_thread, NULL, background_save_write, NULL ) == 0  ) {
+		background_save_running = true;
+		return;
+	}
+	dbg->warning( "karte_t::save_in_background()", "cannot start thread, writing now" );
+#endif
+	background_save_write( NULL );
+	if(  checkpoint  ) {
+		network_journal_t::commit( background_save.error.empty() );
+	}
+	if(  !background_save.error.empty()  ) {
+		static char err_str[512];
+		sprintf( err_str, translator::translate("Error during saving:\n%s"), background_save.error.c_str() );
+		create_win( new news_img(err_str), w_time_delete, magic_none);
+	}
+}
+
+
+void karte_t::save_checkpoint()
+{
+	chdir( env_t::user_dir );
+	char fn[256];
+	// password hashes as for nwc_sync_t, since they are read from there on loading
+	sprintf( fn, "server%d-pwdhash.sve", env_t::server );
+	loadsave_t file;
+	if(  file.wr_open( fn, loadsave_t::save_mode, "hashes", SAVEGAME_VER_NR )  ) {
+		rdwr_player_password_hashes( &file );
+		file.close();
+	}
+	sprintf( fn, "server%d-network.sve", env_t::server );
+	save_in_background( fn, loadsave_t::save_mode, SERVER_SAVEGAME_VER_NR, true );
+	next_checkpoint_time = dr_time() + env_t::server_checkpoint_interval*1000;
+}
+
+
 void karte_t::save(const char *filename, loadsave_t::mode_t savemode, const char *version_str, bool silent )
 {
 DBG_MESSAGE("karte_t::speichern()", "saving game to '%s'", filename);
+	// the background save may use the same file
+	wait_for_background_save( true );
+
 	loadsave_t  file;
 	bool save_temp = strstart( filename, "save/" );
 	const char *savename = save_temp ? "save/_temp.sve" : filename;
@@ -5255,6 +5552,10 @@ bool karte_t::load(const char *filename)
 	bool ok = false;
 	bool restore_player_nr = false;
 	bool server_reload_pwd_hashes = false;
+	// maybe we load what is just written
+	wait_for_background_save( true );
+	// the journal belongs to the old world (see network_journal_t::replay() for recovery)
+	network_journal_t::close();
 	mute_sound(true);
 	display_show_load_pointer(true);
 	loadsave_t file;
@@ -5622,6 +5923,7 @@ DBG_DEBUG("karte_t::laden", "init felder ok");
 	steps = 0;
 	network_frame_count = 0;
 	sync_steps = 0;
+	checklist_digest_valid = false;
 	step_mode = PAUSE_FLAG;
 
 DBG_MESSAGE("karte_t::laden()","savegame loading at tick count %i",ticks);
@@ -5971,8 +6273,7 @@ DBG_MESSAGE("karte_t::laden()", "%d factories loaded", fab_list.get_count());
 	// reroute goods for benchmarking
 	dt = dr_time();
 	FOR(vector_tpl<halthandle_t>, const i, haltestelle_t::get_alle_haltestellen()) {
-		sint16 dummy = 0x7FFF;
-		i->reroute_goods(dummy);
+		i->reroute_goods();
 	}
 	DBG_MESSAGE("reroute_goods()","for all haltstellen_t took %ld ms", dr_time()-dt );
 #endif
@@ -6785,13 +7086,20 @@ void karte_t::do_network_world_command(network_world_command_t *nwc)
 		const int offset = server_checklist.print(buf, "server");
 		LCHKLST(server_sync_step).print(buf + offset, "client");
 		dbg->warning("karte_t:::do_network_world_command", "sync_step=%u  %s", server_sync_step, buf);
-		if(  LCHKLST(server_sync_step)!=server_checklist  ) {
+		const uint32 differ = LCHKLST(server_sync_step).compare_digest( server_checklist );
+		for(  int i=0;  i<checklist_t::DIGEST_COUNT;  i++  ) {
+			if(  differ & (1<<i)  ) {
+				dbg->warning("karte_t:::do_network_world_command", "sync_step=%u: %s differ (server %08x client %08x)", server_sync_step,
+					checklist_t::get_digest_name(i), server_checklist.digest[i], LCHKLST(server_sync_step).digest[i] );
+			}
+		}
+		if(  LCHKLST(server_sync_step)!=server_checklist  ||  differ  ) {
 			dbg->warning("karte_t:::do_network_world_command", "disconnecting due to checklist mismatch" );
 			network_disconnect();
 		}
 	}
 	else {
-		if(  nwc->get_id()==NWC_TOOL  ) {
+		if(  nwc->get_id()==NWC_TOOL  &&  !nwc->is_replayed()  ) {
 			nwc_tool_t *nwt = dynamic_cast<nwc_tool_t *>(nwc);
 			if(  is_checklist_available(nwt->last_sync_step)  &&  LCHKLST(nwt->last_sync_step)!=nwt->last_checklist  ) {
 				// lost synchronisation ...
@@ -6806,6 +7114,9 @@ void karte_t::do_network_world_command(network_world_command_t *nwc)
 				return;
 			}
 		}
+		if(  env_t::server  &&  (nwc->get_id()==NWC_TOOL  ||  nwc->get_id()==NWC_CHG_PLAYER)  ) {
+			network_journal_t::append( nwc );
+		}
 		nwc->do_command(this);
 	}
 }
@@ -6851,6 +7162,7 @@ bool karte_t::interactive(uint32 quit_month)
 
 	finish_loop = false;
 	sync_steps = 0;
+	checklist_digest_valid = false;
 
 	network_frame_count = 0;
 	vector_tpl<uint16>hashes_ok;	// bit set: this client can do something with this player
@@ -6965,14 +7277,23 @@ bool karte_t::interactive(uint32 quit_month)
 					}
 					sync_steps = steps * settings.get_frames_per_step() + network_frame_count;
 					LCHKLST(sync_steps) = checklist_t(get_random_seed(), halthandle_t::get_next_check(), linehandle_t::get_next_check(), convoihandle_t::get_next_check());
+					if(  env_t::networkmode  ) {
+						update_checklist_digest();
+					}
 					// some serverside tasks
 					if(  env_t::networkmode  &&  env_t::server  ) {
-						// broadcast sync info
+						// broadcast sync info (always with a digest, since the clients have calculated it too)
 						if (  (network_frame_count==0  &&  (sint64)dr_time()-(sint64)next_step_time>fix_ratio_frame_time*2)
-								||  (sync_steps % env_t::server_sync_steps_between_checks)==0  ) {
+								||  (sync_steps % env_t::server_sync_steps_between_checks)==0  ||  LCHKLST(sync_steps).has_digest  ) {
 							nwc_check_t* nwc = new nwc_check_t(sync_steps + 1, map_counter, LCHKLST(sync_steps), sync_steps);
 							network_send_all(nwc, true);
 						}
+						// checkpoint for crash recovery (at once, if there is no journal yet, but after a failure only after the interval)
+						// not on maps that can only be saved after rotating them, since the clients would not rotate too
+						if(  network_frame_count==0  &&  env_t::server_checkpoint_interval>0  &&  !nosave_warning  &&  !nosave
+							&&  ((!network_journal_t::is_open()  &&  !network_journal_t::has_failed())  ||  (sint32)(dr_time()-next_checkpoint_time)>=0)  ) {
+							save_checkpoint();
+						}
 					}
 #if DEBUG>4
 					if(  env_t::networkmode  &&  (sync_steps & 7)==0  &&  env_t::verbose_debug>4  ) {
@@ -53,6 +53,9 @@ class memory_rw_t;
 class viewport_t;
 class records_t;
 
+/// sync_steps with a digest of the world state in their checklist
+#define CHECKLIST_DIGEST_INTERVAL (256)
+
 struct checklist_t
 {
 	uint32 random_seed;
@@ -60,9 +63,19 @@ struct checklist_t
 	uint16 line_entry;
 	uint16 convoy_entry;
 
-	checklist_t() : random_seed(0), halt_entry(0), line_entry(0), convoy_entry(0) { }
+	/**
+	 * Short checksums of parts of the world state, only every CHECKLIST_DIGEST_INTERVAL sync_steps.
+	 * Each covers the sync_steps of the previous interval, every one of them adding a slice of the objects.
+	 * A mismatch shows a desync long before the random seeds differ, and where it comes from.
+	 * @see karte_t::update_checklist_digest
+	 */
+	enum { DIGEST_CONVOYS, DIGEST_HALTS, DIGEST_FACTORIES, DIGEST_PLAYERS, DIGEST_COUNT };
+	uint32 digest[DIGEST_COUNT];
+	bool has_digest;
+
+	checklist_t() : random_seed(0), halt_entry(0), line_entry(0), convoy_entry(0), has_digest(false) { }
 	checklist_t(uint32 _random_seed, uint16 _halt_entry, uint16 _line_entry, uint16 _convoy_entry)
-		: random_seed(_random_seed), halt_entry(_halt_entry), line_entry(_line_entry), convoy_entry(_convoy_entry) { }
+		: random_seed(_random_seed), halt_entry(_halt_entry), line_entry(_line_entry), convoy_entry(_convoy_entry), has_digest(false) { }
 
 	bool operator == (const checklist_t &other) const
 	{
@@ -72,6 +85,16 @@ struct checklist_t
 
 	void rdwr(memory_rw_t *buffer);
 	int print(char *buffer, const char *entity) const;
+
+	/// the digest is not part of rdwr(), since older versions do not know it
+	void rdwr_digest(memory_rw_t *buffer);
+
+	/**
+	 * @return bit i set, if the digest i differs (0 if one checklist has no digest)
+	 */
+	uint32 compare_digest(const checklist_t &other) const;
+
+	static const char *get_digest_name(int i);
 };
 
 
@@ -539,6 +562,12 @@ private:
 
 	/// @note variable used in interactive()
 	uint32 sync_steps;
+
+	/// digest parts of the current CHECKLIST_DIGEST_INTERVAL so far, see update_checklist_digest()
+	uint32 checklist_digest_sum[checklist_t::DIGEST_COUNT];
+	/// sync_step of the next slice; if steps are skipped, the sums are incomplete until the next interval
+	uint32 checklist_digest_next;
+	bool checklist_digest_valid;
 #define LAST_CHECKLISTS_COUNT 64
 	/// @note variable used in interactive()
 	checklist_t last_checklists[LAST_CHECKLISTS_COUNT];
@@ -578,6 +607,9 @@ private:
 	 */
 	uint32 last_interaction;
 
+	/// ms, when the server saves the next checkpoint for crash recovery
+	uint32 next_checkpoint_time;
+
 	/**
 	 * ms, when the last step was done.
 	 * To calculate the fps and the simloops.
@@ -730,7 +762,7 @@ private:
 	enum { SYNCX_FLAG = 0x01, GRIDS_FLAG = 0x02 };
 
 	void world_xy_loop(xy_loop_func func, uint8 flags);
-	static void *world_xy_loop_thread(void *);
+	static void world_xy_loop_thread(void *, int thread_num);
 
 	/**
 	 * Loops over plans after load.
@@ -1774,6 +1806,26 @@ public:
 	 */
 	void save(const char *filename, const loadsave_t::mode_t savemode, const char *version, bool silent);
 
+	/**
+	 * Saves the map silently into memory; compressing and writing the file is then done
+	 * by a background thread, so the game only pauses for the saving itself.
+	 */
+	void save_in_background(const char *filename, const loadsave_t::mode_t savemode, const char *version, bool checkpoint=false);
+
+	/**
+	 * Server only: saves server%d-network.sve in the background and starts a new journal
+	 * of the executed commands, so the game can be recovered after a crash.
+	 * Must not be called if nosave_warning is set: save() would rotate the map of the server only.
+	 * @see network_journal_t
+	 */
+	void save_checkpoint();
+
+	/**
+	 * Waits until the last background save is written.
+	 * @param show_error if true, an error during writing is shown in a window
+	 */
+	static void wait_for_background_save(bool show_error);
+
 	/**
 	 * Loads a map from a file.
 	 * @param Filename name of the file to read.
@@ -1813,6 +1865,13 @@ public:
 	const checklist_t& get_last_checklist() const { return LCHKLST(sync_steps); }
 	uint32 get_last_checklist_sync_step() const { return sync_steps; }
 
+	/**
+	 * Adds the slice of this sync_step to the digest of convoys, halts, factories and players,
+	 * so the work is spread over all sync_steps. Every CHECKLIST_DIGEST_INTERVAL sync_steps
+	 * the digest is stored in the checklist of this sync_step. Server and clients do this at the same sync_steps.
+	 */
+	void update_checklist_digest();
+
 	void command_queue_append(network_world_command_t*) const;
 
 	void clear_command_queue() const;
@@ -54,3 +54,70 @@ int simthread_barrier_wait(simthread_barrier_t *barrier)
 }
 
 #endif
+
+
+#ifdef MULTI_THREAD
+#include "../simdebug.h"
+#include "../dataobj/environment.h"
+
+
+static pthread_mutex_t pool_mutex = PTHREAD_MUTEX_INITIALIZER;
+static simthread_barrier_t pool_barrier_start;
+static simthread_barrier_t pool_barrier_end;
+// number of parts of a job: the workers and the calling thread
+static int pool_size = 0;
+
+// the current job
+static simthread_job_t pool_job = NULL;
+static void *pool_param = NULL;
+
+
+static void *pool_thread(void *ptr)
+{
+	const int thread_num = (int)(size_t)ptr;
+	while(true) {
+		simthread_barrier_wait( &pool_barrier_start ); // wait for all to start
+		pool_job( pool_param, thread_num );
+		simthread_barrier_wait( &pool_barrier_end ); // wait for all to finish
+	}
+	return ptr;
+}
+
+
+void simthread_run_parallel(simthread_job_t job, void *param)
+{
+	if(  env_t::num_threads <= 1  ||  pthread_mutex_trylock( &pool_mutex ) != 0  ) {
+		// no other threads available: do all parts here
+		for(  int t = 0;  t < env_t::num_threads;  t++  ) {
+			job( param, t );
+		}
+		return;
+	}
+
+	if(  pool_size == 0  ) {
+		// started once, the threads are never stopped
+		pthread_attr_t attr;
+		pthread_attr_init( &attr );
+		pthread_attr_setdetachstate( &attr, PTHREAD_CREATE_DETACHED );
+		simthread_barrier_init( &pool_barrier_start, NULL, env_t::num_threads );
+		simthread_barrier_init( &pool_barrier_end, NULL, env_t::num_threads );
+		for(  int t = 0;  t < env_t::num_threads - 1;  t++  ) {
+			pthread_t thread;
+			if(  pthread_create( &thread, &attr, pool_thread, (void *)(size_t)t )  ) {
+				dbg->fatal( "simthread_run_parallel()", "cannot multithread, error at thread #%i", t+1 );
+			}
+		}
+		pthread_attr_destroy( &attr );
+		pool_size = env_t::num_threads;
+	}
+
+	pool_job = job;
+	pool_param = param;
+	simthread_barrier_wait( &pool_barrier_start );
+	// the last part we do ourselves
+	job( param, pool_size - 1 );
+	simthread_barrier_wait( &pool_barrier_end );
+
+	pthread_mutex_unlock( &pool_mutex );
+}
+#endif
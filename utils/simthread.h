@@ -52,6 +52,22 @@ int simthread_barrier_wait(simthread_barrier_t *barrier);
 
 #endif
 
+/**
+ * A part of a parallel job, see simthread_run_parallel().
+ * @param thread_num number of the part, 0 .. env_t::num_threads-1
+ */
+typedef void (*simthread_job_t)(void *param, int thread_num);
+
+/**
+ * All parallel loops of the game share one pool of env_t::num_threads-1 threads.
+ * Runs job(param, t) for all t = 0 .. env_t::num_threads-1 at once, the calling thread does the last part.
+ * Returns when all parts are finished. Like karte_t::world_xy_loop(), the threads wait on barriers between the jobs.
+ *
+ * Only one job runs at a time. If the pool is busy (used by another thread, or called from within a job),
+ * the calling thread does all parts itself in ascending order, so a part may only wait for parts with lower numbers.
+ */
+void simthread_run_parallel(simthread_job_t job, void *param);
+
 #endif
 
 #endif
@@ -175,6 +175,13 @@ bool pedestrian_t::sync_step(uint32 delta_t)
 }
 
 
+bool pedestrian_t::sync_step_local(uint32 delta_t)
+{
+	// only if it neither leaves the tile nor vanishes
+	return  time_to_life > (sint32)delta_t  &&  can_drive_local( weg_next + 128*delta_t )  &&  sync_step( delta_t );
+}
+
+
 grund_t* pedestrian_t::hop_check()
 {
 	grund_t *from = welt->lookup(pos_next);
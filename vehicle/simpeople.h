@@ -42,6 +42,8 @@ public:
 
 	bool sync_step(uint32 delta_t);
 
+	bool sync_step_local(uint32 delta_t);
+
 	// prissi: always free
 	virtual bool ist_weg_frei() { return true; }
 	virtual grund_t* hop_check();
@@ -394,6 +394,26 @@ bool private_car_t::sync_step(uint32 delta_t)
 }
 
 
+bool private_car_t::sync_step_local(uint32 delta_t)
+{
+	if(  time_to_life <= (sint32)delta_t  ) {
+		// will be removed
+		return false;
+	}
+	if(  current_speed==0  ) {
+		// checking the traffic jam looks at the next tile
+		if(  ((ms_traffic_jam+delta_t)>>10) != (ms_traffic_jam>>10)  ) {
+			return false;
+		}
+	}
+	else if(  !can_drive_local( weg_next + current_speed*delta_t )  ) {
+		return false;
+	}
+	// now sync_step() will only touch this car
+	return sync_step( delta_t );
+}
+
+
 void private_car_t::rdwr(loadsave_t *file)
 {
 	xml_tag_t s( file, "stadtauto_t" );
@@ -115,6 +115,8 @@ public:
 
 	bool sync_step(uint32 delta_t);
 
+	bool sync_step_local(uint32 delta_t);
+
 	void hop(grund_t *gr);
 	bool ist_weg_frei(grund_t *gr);
 
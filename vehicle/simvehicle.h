@@ -115,6 +115,14 @@ public:
 
 	uint32 do_drive(uint32 dist);	// basis movement code
 
+	/**
+	 * @return true, if do_drive(dist) stays on this tile and changes only this vehicle
+	 */
+	bool can_drive_local(uint32 dist) const {
+		const uint32 steps_to_do = dist >> YARDS_PER_VEHICLE_STEP_SHIFT;
+		return  steps_to_do == 0  ||  (get_flag(obj_t::dirty)  &&  steps + steps_to_do <= steps_next);
+	}
+
 	inline void set_bild( image_id b ) { image = b; }
 	virtual image_id get_image() const {return image;}
 